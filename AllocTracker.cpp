@@ -0,0 +1,186 @@
+#include "AllocTracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+
+    std::atomic<bool> trackingEnabled = false;
+    std::atomic<int64_t> allocCount = 0;
+    std::atomic<int64_t> freeCount = 0;
+    std::atomic<int64_t> allocBytes = 0;
+    std::atomic<int64_t> liveBytes = 0;
+    std::atomic<int64_t> peakLiveBytes = 0;
+
+    // size of the block as reported by the C runtime, 0 if the platform cannot tell
+    std::size_t blockSize(void* p) noexcept
+    {
+#if defined(_WIN32)
+        return _msize(p);
+#elif defined(__APPLE__)
+        return malloc_size(p);
+#elif defined(__GLIBC__)
+        return malloc_usable_size(p);
+#else
+        return 0;
+#endif
+    }
+
+    // without tracking the operators are plain malloc/free, blocks carry no extra header
+    void* trackedAlloc(std::size_t size) noexcept
+    {
+        void* p = nullptr;
+        while ((p = std::malloc(size ? size : 1)) == nullptr) {
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) {
+                return nullptr;
+            }
+            try {
+                handler();
+            }
+            catch (...) {
+                return nullptr;
+            }
+        }
+
+        if (trackingEnabled.load(std::memory_order_relaxed)) {
+            const auto bytes = static_cast<int64_t>(blockSize(p));
+            allocCount.fetch_add(1, std::memory_order_relaxed);
+            allocBytes.fetch_add(bytes, std::memory_order_relaxed);
+            const int64_t live = liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            int64_t peak = peakLiveBytes.load(std::memory_order_relaxed);
+            while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+            }
+        }
+        return p;
+    }
+
+    void trackedFree(void* p) noexcept
+    {
+        if (!p) {
+            return;
+        }
+        if (trackingEnabled.load(std::memory_order_relaxed)) {
+            freeCount.fetch_add(1, std::memory_order_relaxed);
+            liveBytes.fetch_sub(static_cast<int64_t>(blockSize(p)), std::memory_order_relaxed);
+        }
+        std::free(p);
+    }
+
+} // namespace
+
+namespace AllocTracker {
+
+    void enable(bool value)
+    {
+        trackingEnabled = value;
+    }
+
+    bool enabled()
+    {
+        return trackingEnabled;
+    }
+
+    Counters snapshot()
+    {
+        return {
+            allocCount.load(),
+            freeCount.load(),
+            allocBytes.load(),
+            liveBytes.load(),
+            peakLiveBytes.load()
+        };
+    }
+
+    void resetPeak()
+    {
+        peakLiveBytes = liveBytes.load();
+    }
+
+    HeapStat heapStat()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS_EX counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters))) {
+            return { true, static_cast<int64_t>(counters.PrivateUsage) };
+        }
+        return { false, 0 };
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        const struct mallinfo2 info = mallinfo2();
+        return { true, static_cast<int64_t>(info.uordblks + info.hblkhd) };
+#else
+        return { false, 0 };
+#endif
+    }
+
+} // namespace AllocTracker
+
+void* operator new(std::size_t size)
+{
+    if (void* p = trackedAlloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (void* p = trackedAlloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedAlloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    trackedFree(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    trackedFree(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    trackedFree(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    trackedFree(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    trackedFree(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    trackedFree(p);
+}
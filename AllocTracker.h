@@ -0,0 +1,43 @@
+#pragma once
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <cstdint>
+
+/// <summary>
+/// Counters of the replaced global operator new/delete and the C runtime heap usage.
+/// The operators always allocate with plain malloc; allocations are counted only while tracking
+/// is enabled. Byte counters use the block size reported by the C runtime (_msize, malloc_usable_size),
+/// so live bytes are not tracked on platforms without such a function.
+/// Enable tracking once at startup: blocks allocated before are counted when freed.
+/// </summary>
+namespace AllocTracker {
+
+    struct Counters {
+        int64_t alloc_count;
+        int64_t free_count;
+        int64_t alloc_bytes;
+        int64_t live_bytes;
+        int64_t peak_live_bytes;
+    };
+
+    struct HeapStat {
+        bool available;
+        // bytes in use by malloc, including memory allocated by fbclient
+        int64_t in_use;
+    };
+
+    void enable(bool value);
+
+    bool enabled();
+
+    Counters snapshot();
+
+    // starts a new peak measurement from the current live size
+    void resetPeak();
+
+    HeapStat heapStat();
+
+} // namespace AllocTracker
+
+#endif // ALLOC_TRACKER_H
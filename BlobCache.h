@@ -0,0 +1,146 @@
+#pragma once
+#ifndef BLOB_CACHE_H
+#define BLOB_CACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/// <summary>
+/// Client-side LRU cache of BLOB contents bounded by the total content size.
+/// An entry is keyed by the record ID, the BLOB ID and the snapshot number of the reading
+/// transaction: an update of the record gives a new BLOB ID, so a stale value is never found.
+/// Not thread safe.
+/// </summary>
+class BlobCache final
+{
+public:
+    struct Key {
+        int64_t id;
+        uint64_t blobId;
+        int64_t snapshot;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct Stat {
+        int64_t hits = 0;
+        int64_t misses = 0;
+        int64_t evictions = 0;
+        // values larger than the whole cache
+        int64_t rejected = 0;
+    };
+private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const
+        {
+            const std::hash<uint64_t> h;
+            size_t seed = h(static_cast<uint64_t>(key.id));
+            seed ^= h(key.blobId) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+            seed ^= h(static_cast<uint64_t>(key.snapshot)) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+
+    using Entry = std::pair<Key, std::string>;
+    using Index = std::unordered_map<Key, std::list<Entry>::iterator, KeyHash>;
+
+    // most recently used first
+    std::list<Entry> m_lru;
+    Index m_index;
+    size_t m_capacity;
+    size_t m_size = 0;
+    Stat m_stat;
+public:
+    explicit BlobCache(size_t capacity)
+        : m_capacity(capacity)
+    {}
+
+    BlobCache(const BlobCache&) = delete;
+    BlobCache& operator=(const BlobCache&) = delete;
+
+    /// <summary>
+    /// Returns the cached content and makes it the most recently used, or nullptr.
+    /// The pointer is valid until the next insert().
+    /// </summary>
+    const std::string* find(const Key& key)
+    {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            ++m_stat.misses;
+            return nullptr;
+        }
+        ++m_stat.hits;
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return &it->second->second;
+    }
+
+    /// <summary>
+    /// Adds the content, evicting the least recently used entries to stay within the capacity.
+    /// </summary>
+    void insert(const Key& key, std::string content)
+    {
+        if (content.size() > m_capacity) {
+            ++m_stat.rejected;
+            return;
+        }
+        if (auto it = m_index.find(key); it != m_index.end()) {
+            m_size -= it->second->second.size();
+            m_lru.erase(it->second);
+            m_index.erase(it);
+        }
+        while (m_size + content.size() > m_capacity) {
+            const auto& victim = m_lru.back();
+            m_size -= victim.second.size();
+            m_index.erase(victim.first);
+            m_lru.pop_back();
+            ++m_stat.evictions;
+        }
+        m_size += content.size();
+        m_lru.emplace_front(key, std::move(content));
+        m_index.emplace(key, m_lru.begin());
+    }
+
+    void clear()
+    {
+        m_lru.clear();
+        m_index.clear();
+        m_size = 0;
+    }
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    // content bytes held by the cache
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    size_t entryCount() const
+    {
+        return m_lru.size();
+    }
+
+    // content bytes with string capacity plus an estimate of the list and hash table nodes
+    size_t memoryUsage() const
+    {
+        size_t bytes = m_index.bucket_count() * sizeof(void*);
+        for (const auto& entry : m_lru) {
+            bytes += entry.second.capacity() + sizeof(Entry) + 2 * sizeof(void*) + sizeof(Index::value_type) + sizeof(void*);
+        }
+        return bytes;
+    }
+
+    const Stat& stat() const
+    {
+        return m_stat;
+    }
+};
+
+#endif // BLOB_CACHE_H
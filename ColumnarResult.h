@@ -0,0 +1,149 @@
+#pragma once
+#ifndef COLUMNAR_RESULT_H
+#define COLUMNAR_RESULT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/// <summary>
+/// Result set of (ID, content) rows stored by columns: identifiers in one contiguous array,
+/// content offsets and lengths in a second one and all content bytes in a single growing buffer.
+/// VARCHAR and BLOB values are stored the same way; NULL is stored as an empty value.
+/// </summary>
+class ColumnarResult final
+{
+public:
+    struct Extent {
+        uint64_t offset;
+        uint64_t length;
+    };
+private:
+    std::vector<int64_t> m_ids;
+    std::vector<Extent> m_extents;
+    std::unique_ptr<char[]> m_data;
+    size_t m_size = 0;
+    size_t m_capacity = 0;
+    size_t m_rowStart = 0;
+public:
+    ColumnarResult() = default;
+
+    ColumnarResult(const ColumnarResult&) = delete;
+    ColumnarResult& operator=(const ColumnarResult&) = delete;
+
+    void reserve(size_t rows, size_t bytes)
+    {
+        m_ids.reserve(rows);
+        m_extents.reserve(rows);
+        ensureCapacity(bytes);
+    }
+
+    void clear()
+    {
+        m_ids.clear();
+        m_extents.clear();
+        m_size = 0;
+        m_rowStart = 0;
+    }
+
+    /// <summary>
+    /// Adds a row with the whole value at once, as for a VARCHAR column.
+    /// </summary>
+    void append(int64_t id, const char* data, size_t length)
+    {
+        beginRow(id);
+        std::memcpy(grow(length), data, length);
+        endRow();
+    }
+
+    /// <summary>
+    /// Starts a row whose value is written in parts with grow()/shrink(), as for BLOB segments.
+    /// </summary>
+    void beginRow(int64_t id)
+    {
+        m_ids.push_back(id);
+        m_rowStart = m_size;
+    }
+
+    /// <summary>
+    /// Extends the current value by length bytes and returns the place to write them to.
+    /// The pointer is valid until the next call of grow().
+    /// </summary>
+    char* grow(size_t length)
+    {
+        ensureCapacity(m_size + length);
+        char* p = m_data.get() + m_size;
+        m_size += length;
+        return p;
+    }
+
+    /// <summary>
+    /// Gives back bytes requested by the last grow() but not written.
+    /// </summary>
+    void shrink(size_t unused)
+    {
+        m_size -= std::min(unused, m_size - m_rowStart);
+    }
+
+    void endRow()
+    {
+        m_extents.push_back({ m_rowStart, m_size - m_rowStart });
+    }
+
+    size_t size() const
+    {
+        return m_ids.size();
+    }
+
+    size_t dataSize() const
+    {
+        return m_size;
+    }
+
+    // bytes held by the container, including unused capacity
+    size_t memoryUsage() const
+    {
+        return m_ids.capacity() * sizeof(int64_t) + m_extents.capacity() * sizeof(Extent) + m_capacity;
+    }
+
+    std::span<const int64_t> ids() const
+    {
+        return m_ids;
+    }
+
+    std::span<const Extent> extents() const
+    {
+        return m_extents;
+    }
+
+    int64_t id(size_t row) const
+    {
+        return m_ids[row];
+    }
+
+    std::string_view content(size_t row) const
+    {
+        const auto& extent = m_extents[row];
+        return std::string_view(m_data.get() + extent.offset, extent.length);
+    }
+private:
+    void ensureCapacity(size_t required)
+    {
+        if (required <= m_capacity) {
+            return;
+        }
+        const size_t capacity = std::max(required, m_capacity * 2);
+        std::unique_ptr<char[]> data(new char[capacity]);
+        if (m_size > 0) {
+            std::memcpy(data.get(), m_data.get(), m_size);
+        }
+        m_data = std::move(data);
+        m_capacity = capacity;
+    }
+};
+
+#endif // COLUMNAR_RESULT_H
@@ -0,0 +1,200 @@
+#include "FetchRecording.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    constexpr char RECORDING_MAGIC[8] = { 'F', 'B', 'B', 'L', 'O', 'B', 'R', 'C' };
+    constexpr uint32_t RECORDING_VERSION = 1;
+
+} // namespace
+
+namespace FetchRecording {
+
+    Recorder::Recorder(const std::string& fileName)
+        : m_out(fileName, std::ios::out | std::ios::binary | std::ios::trunc)
+    {
+        if (!m_out) {
+            throw std::runtime_error("Cannot open recording file " + fileName);
+        }
+        // the header is rewritten by finish()
+        FileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        m_out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    void Recorder::add(EventKind kind, int64_t id, const char* data, size_t length, int64_t time_ns)
+    {
+        m_events.push_back({ kind, 0, id, m_dataSize, length, time_ns });
+        if (length > 0) {
+            m_out.write(data, static_cast<std::streamsize>(length));
+            m_dataSize += length;
+        }
+    }
+
+    void Recorder::addRow(int64_t id, const char* data, size_t length, int64_t time_ns)
+    {
+        add(EventKind::ROW_VARCHAR, id, data, length, time_ns);
+    }
+
+    void Recorder::addNullRow(int64_t id, int64_t time_ns)
+    {
+        add(EventKind::ROW_NULL, id, nullptr, 0, time_ns);
+    }
+
+    void Recorder::addBlobRow(int64_t id, int64_t time_ns)
+    {
+        m_lastId = id;
+        add(EventKind::ROW_BLOB, id, nullptr, 0, time_ns);
+    }
+
+    void Recorder::addSegment(const char* data, size_t length, int64_t time_ns)
+    {
+        add(EventKind::BLOB_SEGMENT, m_lastId, data, length, time_ns);
+    }
+
+    void Recorder::addBlobEnd(int64_t time_ns)
+    {
+        add(EventKind::BLOB_END, m_lastId, nullptr, 0, time_ns);
+    }
+
+    void Recorder::finish()
+    {
+        // keep the event table aligned for the mapping
+        const uint64_t data_end = sizeof(FileHeader) + m_dataSize;
+        const uint64_t events_offset = (data_end + alignof(Event) - 1) / alignof(Event) * alignof(Event);
+        const char padding[alignof(Event)] = {};
+        m_out.write(padding, static_cast<std::streamsize>(events_offset - data_end));
+        m_out.write(reinterpret_cast<const char*>(m_events.data()), static_cast<std::streamsize>(m_events.size() * sizeof(Event)));
+
+        FileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+        header.version = RECORDING_VERSION;
+        header.event_count = m_events.size();
+        header.events_offset = events_offset;
+        header.data_offset = sizeof(FileHeader);
+        header.data_size = m_dataSize;
+        m_out.seekp(0);
+        m_out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        m_out.close();
+        if (!m_out) {
+            throw std::runtime_error("Cannot write recording file");
+        }
+    }
+
+    MappedRecording::MappedRecording(const std::string& fileName)
+    {
+#if defined(_WIN32)
+        m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            m_file = nullptr;
+            throw std::runtime_error("Cannot open recording file " + fileName);
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+            unmap();
+            throw std::runtime_error("Cannot get size of recording file " + fileName);
+        }
+        m_size = static_cast<size_t>(size.QuadPart);
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping) {
+            m_base = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (!m_base) {
+            unmap();
+            throw std::runtime_error("Cannot map recording file " + fileName);
+        }
+#else
+        m_fd = ::open(fileName.c_str(), O_RDONLY);
+        if (m_fd < 0) {
+            throw std::runtime_error("Cannot open recording file " + fileName);
+        }
+        struct stat st;
+        if (fstat(m_fd, &st) != 0 || st.st_size == 0) {
+            unmap();
+            throw std::runtime_error("Cannot get size of recording file " + fileName);
+        }
+        m_size = static_cast<size_t>(st.st_size);
+        void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (p == MAP_FAILED) {
+            unmap();
+            throw std::runtime_error("Cannot map recording file " + fileName);
+        }
+        m_base = static_cast<const unsigned char*>(p);
+#endif
+        FileHeader header;
+        if (m_size < sizeof(header)) {
+            unmap();
+            throw std::runtime_error("Recording file " + fileName + " is too short");
+        }
+        std::memcpy(&header, m_base, sizeof(header));
+        if (std::memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0 || header.version != RECORDING_VERSION) {
+            unmap();
+            throw std::runtime_error("File " + fileName + " is not a fetch recording");
+        }
+        // ranges are checked as offset <= size && length <= size - offset, so corrupt values cannot overflow
+        const uint64_t fileSize = m_size;
+        if (header.data_offset > fileSize || header.data_size > fileSize - header.data_offset ||
+            header.events_offset % alignof(Event) != 0 || header.events_offset > fileSize ||
+            header.event_count > (fileSize - header.events_offset) / sizeof(Event))
+        {
+            unmap();
+            throw std::runtime_error("Recording file " + fileName + " is truncated");
+        }
+        const auto* events = reinterpret_cast<const Event*>(m_base + header.events_offset);
+        for (uint64_t i = 0; i < header.event_count; i++) {
+            if (events[i].offset > header.data_size || events[i].length > header.data_size - events[i].offset) {
+                unmap();
+                throw std::runtime_error("Recording file " + fileName + " is corrupt: event " + std::to_string(i) + " is outside the data section");
+            }
+        }
+        m_data = reinterpret_cast<const char*>(m_base + header.data_offset);
+        m_events = std::span<const Event>(events, static_cast<size_t>(header.event_count));
+    }
+
+    MappedRecording::~MappedRecording()
+    {
+        unmap();
+    }
+
+    void MappedRecording::unmap()
+    {
+#if defined(_WIN32)
+        if (m_base) {
+            UnmapViewOfFile(m_base);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+        }
+        if (m_file) {
+            CloseHandle(m_file);
+        }
+        m_mapping = nullptr;
+        m_file = nullptr;
+#else
+        if (m_base) {
+            munmap(const_cast<unsigned char*>(m_base), m_size);
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+        m_fd = -1;
+#endif
+        m_base = nullptr;
+    }
+
+} // namespace FetchRecording
@@ -0,0 +1,129 @@
+#pragma once
+#ifndef FETCH_RECORDING_H
+#define FETCH_RECORDING_H
+
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Recording of fetched rows and BLOB segments for replay without a server.
+/// The file holds a header, the content bytes and the event table, and is read through a memory mapping.
+/// </summary>
+namespace FetchRecording {
+
+    enum class EventKind : uint32_t {
+        ROW_VARCHAR,   // row with the value in the event data
+        ROW_NULL,      // row with NULL value
+        ROW_BLOB,      // row whose value follows as BLOB_SEGMENT events
+        BLOB_SEGMENT,  // part of the BLOB value of the last ROW_BLOB
+        BLOB_END       // BLOB of the last ROW_BLOB is closed
+    };
+
+    struct Event {
+        EventKind kind;
+        uint32_t reserved;
+        int64_t id;
+        // content bytes, relative to the start of the data section
+        uint64_t offset;
+        uint64_t length;
+        // completion time of the call, relative to the start of recording
+        int64_t time_ns;
+    };
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t event_count;
+        uint64_t events_offset;
+        uint64_t data_offset;
+        uint64_t data_size;
+    };
+
+    /// <summary>
+    /// Writes the content bytes to the file as they come and the event table at the end.
+    /// </summary>
+    class Recorder final
+    {
+    private:
+        std::ofstream m_out;
+        std::vector<Event> m_events;
+        uint64_t m_dataSize = 0;
+        int64_t m_lastId = 0;
+    public:
+        explicit Recorder(const std::string& fileName);
+
+        void addRow(int64_t id, const char* data, size_t length, int64_t time_ns);
+
+        void addNullRow(int64_t id, int64_t time_ns);
+
+        void addBlobRow(int64_t id, int64_t time_ns);
+
+        void addSegment(const char* data, size_t length, int64_t time_ns);
+
+        void addBlobEnd(int64_t time_ns);
+
+        size_t eventCount() const
+        {
+            return m_events.size();
+        }
+
+        uint64_t dataSize() const
+        {
+            return m_dataSize;
+        }
+
+        // writes the event table and the header
+        void finish();
+    private:
+        void add(EventKind kind, int64_t id, const char* data, size_t length, int64_t time_ns);
+    };
+
+    /// <summary>
+    /// Read-only memory mapping of a recording.
+    /// </summary>
+    class MappedRecording final
+    {
+    private:
+        const unsigned char* m_base = nullptr;
+        size_t m_size = 0;
+#if defined(_WIN32)
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#else
+        int m_fd = -1;
+#endif
+        std::span<const Event> m_events;
+        const char* m_data = nullptr;
+    public:
+        explicit MappedRecording(const std::string& fileName);
+
+        ~MappedRecording();
+
+        MappedRecording(const MappedRecording&) = delete;
+        MappedRecording& operator=(const MappedRecording&) = delete;
+
+        std::span<const Event> events() const
+        {
+            return m_events;
+        }
+
+        const char* data(const Event& event) const
+        {
+            return m_data + event.offset;
+        }
+
+        size_t fileSize() const
+        {
+            return m_size;
+        }
+    private:
+        void unmap();
+    };
+
+} // namespace FetchRecording
+
+#endif // FETCH_RECORDING_H
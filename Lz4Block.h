@@ -0,0 +1,209 @@
+#pragma once
+#ifndef LZ4_BLOCK_H
+#define LZ4_BLOCK_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// <summary>
+/// Compressor and decompressor of the LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md).
+/// The whole value is one block; the decompressed size is not stored in the block and has to be kept by the caller.
+/// The compressor is the simple greedy single-hash variant, fast but with a lower ratio than the reference one.
+/// </summary>
+namespace Lz4Block {
+
+    namespace detail {
+
+        constexpr size_t MIN_MATCH = 4;
+        // the last 5 bytes are always literals
+        constexpr size_t LAST_LITERALS = 5;
+        // the last match starts at least 12 bytes before the end
+        constexpr size_t MF_LIMIT = 12;
+        constexpr size_t MAX_OFFSET = 65535;
+        constexpr unsigned HASH_BITS = 16;
+
+        inline uint32_t read32(const unsigned char* p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t hash(uint32_t sequence)
+        {
+            return (sequence * 2654435761U) >> (32 - HASH_BITS);
+        }
+
+        inline unsigned char* writeLength(unsigned char* op, size_t length)
+        {
+            for (; length >= 255; length -= 255) {
+                *op++ = 255;
+            }
+            *op++ = static_cast<unsigned char>(length);
+            return op;
+        }
+
+        inline unsigned char* writeSequence(unsigned char* op, const unsigned char* literals, size_t literal_length,
+            size_t offset, size_t match_length)
+        {
+            unsigned char* token = op++;
+            if (literal_length >= 15) {
+                *token = 15 << 4;
+                op = writeLength(op, literal_length - 15);
+            }
+            else {
+                *token = static_cast<unsigned char>(literal_length << 4);
+            }
+            std::memcpy(op, literals, literal_length);
+            op += literal_length;
+            if (match_length == 0) {
+                return op;
+            }
+            *op++ = static_cast<unsigned char>(offset & 0xFF);
+            *op++ = static_cast<unsigned char>(offset >> 8);
+            match_length -= MIN_MATCH;
+            if (match_length >= 15) {
+                *token |= 15;
+                op = writeLength(op, match_length - 15);
+            }
+            else {
+                *token |= static_cast<unsigned char>(match_length);
+            }
+            return op;
+        }
+
+    } // namespace detail
+
+    inline size_t compressBound(size_t size)
+    {
+        return size + size / 255 + 16;
+    }
+
+    /// <summary>
+    /// Compresses src into one LZ4 block.
+    /// </summary>
+    inline std::string compress(std::string_view src)
+    {
+        using namespace detail;
+
+        std::string dst(compressBound(src.size()), '\0');
+        const auto* base = reinterpret_cast<const unsigned char*>(src.data());
+        const size_t n = src.size();
+        auto* op = reinterpret_cast<unsigned char*>(dst.data());
+        size_t anchor = 0;
+
+        if (n >= MF_LIMIT + 1) {
+            const size_t match_limit = n - LAST_LITERALS;
+            const size_t mf_limit = n - MF_LIMIT;
+            std::vector<uint32_t> table(size_t{ 1 } << HASH_BITS, 0);
+            size_t ip = 1;
+            while (ip < mf_limit) {
+                const uint32_t sequence = read32(base + ip);
+                const uint32_t h = hash(sequence);
+                size_t ref = table[h];
+                table[h] = static_cast<uint32_t>(ip);
+                if (ip - ref > MAX_OFFSET || read32(base + ref) != sequence) {
+                    ++ip;
+                    continue;
+                }
+                while (ip > anchor && ref > 0 && base[ip - 1] == base[ref - 1]) {
+                    --ip;
+                    --ref;
+                }
+                size_t length = MIN_MATCH;
+                while (ip + length < match_limit && base[ref + length] == base[ip + length]) {
+                    ++length;
+                }
+                op = writeSequence(op, base + anchor, ip - anchor, ip - ref, length);
+                ip += length;
+                anchor = ip;
+                if (ip < mf_limit) {
+                    table[hash(read32(base + ip - 2))] = static_cast<uint32_t>(ip - 2);
+                }
+            }
+        }
+        op = writeSequence(op, base + anchor, n - anchor, 0, 0);
+
+        dst.resize(static_cast<size_t>(op - reinterpret_cast<unsigned char*>(dst.data())));
+        return dst;
+    }
+
+    /// <summary>
+    /// Decompresses one LZ4 block into dst. Returns false if the block is malformed
+    /// or does not decompress to exactly dst_size bytes.
+    /// </summary>
+    inline bool decompress(const char* src, size_t src_size, char* dst, size_t dst_size)
+    {
+        using namespace detail;
+
+        const auto* ip = reinterpret_cast<const unsigned char*>(src);
+        const auto* const iend = ip + src_size;
+        auto* op = reinterpret_cast<unsigned char*>(dst);
+        auto* const ostart = op;
+        auto* const oend = op + dst_size;
+
+        auto readLength = [&ip, iend](size_t& length) {
+            unsigned char b;
+            do {
+                if (ip == iend) {
+                    return false;
+                }
+                b = *ip++;
+                length += b;
+            } while (b == 255);
+            return true;
+        };
+
+        while (ip < iend) {
+            const unsigned char token = *ip++;
+            size_t literal_length = token >> 4;
+            if (literal_length == 15 && !readLength(literal_length)) {
+                return false;
+            }
+            if (literal_length > static_cast<size_t>(iend - ip) || literal_length > static_cast<size_t>(oend - op)) {
+                return false;
+            }
+            std::memcpy(op, ip, literal_length);
+            ip += literal_length;
+            op += literal_length;
+            if (ip == iend) {
+                break;
+            }
+
+            if (iend - ip < 2) {
+                return false;
+            }
+            const size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+            ip += 2;
+            if (offset == 0 || offset > static_cast<size_t>(op - ostart)) {
+                return false;
+            }
+            size_t match_length = token & 15;
+            if (match_length == 15 && !readLength(match_length)) {
+                return false;
+            }
+            match_length += MIN_MATCH;
+            if (match_length > static_cast<size_t>(oend - op)) {
+                return false;
+            }
+            const unsigned char* match = op - offset;
+            if (offset >= match_length) {
+                std::memcpy(op, match, match_length);
+                op += match_length;
+            }
+            else {
+                // overlapping copy repeats the last offset bytes
+                for (size_t i = 0; i < match_length; i++) {
+                    *op++ = *match++;
+                }
+            }
+        }
+        return op == oend;
+    }
+
+} // namespace Lz4Block
+
+#endif // LZ4_BLOCK_H
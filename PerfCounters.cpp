@@ -0,0 +1,189 @@
+#include "PerfCounters.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    struct CounterDef {
+        const char* name;
+        uint32_t type;
+        uint64_t config;
+    };
+
+#if defined(__linux__)
+    const CounterDef COUNTER_DEFS[PerfCounters::COUNTER_COUNT] = {
+        { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { "cache misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { "branch misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { "task clock, ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+        { "context switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES }
+    };
+
+    int counterFds[PerfCounters::COUNTER_COUNT] = { -1, -1, -1, -1, -1, -1 };
+    bool countersOpen = false;
+
+    int perfEventOpen(uint32_t type, uint64_t config, bool excludeKernel)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.inherit = 1;
+        attr.exclude_kernel = excludeKernel ? 1 : 0;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#else
+    const CounterDef COUNTER_DEFS[PerfCounters::COUNTER_COUNT] = {
+        { "cycles", 0, 0 },
+        { "instructions", 0, 0 },
+        { "cache misses", 0, 0 },
+        { "branch misses", 0, 0 },
+        { "task clock, ns", 0, 0 },
+        { "context switches", 0, 0 }
+    };
+#endif
+
+} // namespace
+
+namespace PerfCounters {
+
+    const char* counterName(Counter counter)
+    {
+        return COUNTER_DEFS[counter].name;
+    }
+
+#if defined(__linux__)
+    bool open(std::string& error)
+    {
+        close();
+        int lastErrno = 0;
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            // kernel mode counting is denied with perf_event_paranoid >= 2
+            int fd = perfEventOpen(COUNTER_DEFS[i].type, COUNTER_DEFS[i].config, false);
+            if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+                fd = perfEventOpen(COUNTER_DEFS[i].type, COUNTER_DEFS[i].config, true);
+            }
+            if (fd < 0) {
+                lastErrno = errno;
+                continue;
+            }
+            counterFds[i] = fd;
+            countersOpen = true;
+        }
+        if (!countersOpen) {
+            error = std::string("perf_event_open failed: ") + std::strerror(lastErrno) +
+                ", check /proc/sys/kernel/perf_event_paranoid";
+        }
+        return countersOpen;
+    }
+
+    bool isOpen()
+    {
+        return countersOpen;
+    }
+
+    Values read()
+    {
+        Values values;
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            values.value[i] = -1;
+            if (counterFds[i] < 0) {
+                continue;
+            }
+            // value, time enabled, time running
+            uint64_t data[3] = { 0, 0, 0 };
+            if (::read(counterFds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+                continue;
+            }
+            if (data[2] < data[1]) {
+                // the counter was multiplexed, extrapolate to the enabled time
+                values.value[i] = static_cast<int64_t>(static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]));
+            }
+            else {
+                values.value[i] = static_cast<int64_t>(data[0]);
+            }
+        }
+        return values;
+    }
+
+    void close()
+    {
+        for (auto& fd : counterFds) {
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+        countersOpen = false;
+    }
+#else
+    bool open(std::string& error)
+    {
+        error = "performance counters are supported on Linux only";
+        return false;
+    }
+
+    bool isOpen()
+    {
+        return false;
+    }
+
+    Values read()
+    {
+        Values values;
+        for (auto& value : values.value) {
+            value = -1;
+        }
+        return values;
+    }
+
+    void close()
+    {
+    }
+#endif
+
+    std::chrono::microseconds processCpuTime()
+    {
+#if defined(_WIN32)
+        FILETIME creationTime, exitTime, kernelTime, userTime;
+        if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+            return std::chrono::microseconds(0);
+        }
+        auto ticks = [](const FILETIME& t) {
+            return (static_cast<int64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+        };
+        // FILETIME is in 100 ns units
+        return std::chrono::microseconds((ticks(kernelTime) + ticks(userTime)) / 10);
+#else
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return std::chrono::microseconds(0);
+        }
+        auto micros = [](const timeval& t) {
+            return static_cast<int64_t>(t.tv_sec) * 1'000'000 + t.tv_usec;
+        };
+        return std::chrono::microseconds(micros(usage.ru_utime) + micros(usage.ru_stime));
+#endif
+    }
+
+} // namespace PerfCounters
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Hardware and software performance counters of the client process opened with perf_event_open.
+/// Available on Linux only. Counters that cannot be opened are reported as missing.
+/// </summary>
+namespace PerfCounters {
+
+    enum Counter { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, TASK_CLOCK, CONTEXT_SWITCHES, COUNTER_COUNT };
+
+    struct Values {
+        // counter value, scaled when the kernel multiplexed the counter, or -1 if it is unavailable
+        int64_t value[COUNTER_COUNT];
+    };
+
+    const char* counterName(Counter counter);
+
+    // opens the counters for the calling thread and threads it creates later;
+    // returns false and the reason if none of the counters could be opened
+    bool open(std::string& error);
+
+    bool isOpen();
+
+    Values read();
+
+    void close();
+
+    // user and kernel CPU time of the whole process, available on all platforms
+    std::chrono::microseconds processCpuTime();
+
+} // namespace PerfCounters
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,429 @@
+#pragma once
+#ifndef WIRE_SPANS_H
+#define WIRE_SPANS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "firebird/Interface.h"
+
+/// <summary>
+/// Scoped measurement of wire counters and elapsed time of an attachment.
+///
+///   {
+///       WireSpans::Span span(status, att, "load order");
+///       ...
+///       {
+///           WireSpans::Span blob(status, att, "blob");   // aggregated as "load order/blob"
+///           ...
+///       }
+///   }
+///
+/// Spans nest per thread and must end in reverse order of creation. Time and wire counter deltas
+/// are aggregated per label path in thread-local storage and merged when the thread ends.
+/// Every wire counter read is an IAttachment::getInfo call, so sampled spans read the counters
+/// only for every N-th span of a label (setSampleEvery); the other spans measure time only.
+/// Header only, depends on the Firebird OO API.
+/// </summary>
+namespace WireSpans {
+
+    struct FbWireStat {
+        int64_t wire_out_packets;
+        int64_t wire_in_packets;
+        int64_t wire_out_bytes;
+        int64_t wire_in_bytes;
+        int64_t wire_snd_packets;
+        int64_t wire_rcv_packets;
+        int64_t wire_snd_bytes;
+        int64_t wire_rcv_bytes;
+        int64_t wire_roundtrips;
+    };
+
+    inline FbWireStat operator-(const FbWireStat& a, const FbWireStat& b)
+    {
+        return {
+            a.wire_out_packets - b.wire_out_packets,
+            a.wire_in_packets - b.wire_in_packets,
+            a.wire_out_bytes - b.wire_out_bytes,
+            a.wire_in_bytes - b.wire_in_bytes,
+            a.wire_snd_packets - b.wire_snd_packets,
+            a.wire_rcv_packets - b.wire_rcv_packets,
+            a.wire_snd_bytes - b.wire_snd_bytes,
+            a.wire_rcv_bytes - b.wire_rcv_bytes,
+            a.wire_roundtrips - b.wire_roundtrips
+        };
+    }
+
+    inline FbWireStat& operator+=(FbWireStat& a, const FbWireStat& b)
+    {
+        a.wire_out_packets += b.wire_out_packets;
+        a.wire_in_packets += b.wire_in_packets;
+        a.wire_out_bytes += b.wire_out_bytes;
+        a.wire_in_bytes += b.wire_in_bytes;
+        a.wire_snd_packets += b.wire_snd_packets;
+        a.wire_rcv_packets += b.wire_rcv_packets;
+        a.wire_snd_bytes += b.wire_snd_bytes;
+        a.wire_rcv_bytes += b.wire_rcv_bytes;
+        a.wire_roundtrips += b.wire_roundtrips;
+        return a;
+    }
+
+    inline int64_t portable_integer(const unsigned char* ptr, short length)
+    {
+        if (!ptr || length <= 0 || length > 8)
+            return 0;
+
+        int64_t value = 0;
+        int shift = 0;
+
+        while (--length > 0) {
+            value += (static_cast<int64_t>(*ptr++)) << shift;
+            shift += 8;
+        }
+
+        value += (static_cast<int64_t>(static_cast<char>(*ptr))) << shift;
+
+        return value;
+    }
+
+    /// <summary>
+    /// Reads the wire counters of the attachment.
+    /// </summary>
+    /// <returns>false if the client library does not report wire statistics</returns>
+    inline bool getWireStat(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, FbWireStat& stat)
+    {
+        ISC_UCHAR buffer[1024];
+        const unsigned char info_options[] = {
+            fb_info_wire_out_packets, fb_info_wire_in_packets,
+            fb_info_wire_out_bytes, fb_info_wire_in_bytes,
+            fb_info_wire_snd_packets, fb_info_wire_rcv_packets,
+            fb_info_wire_snd_bytes, fb_info_wire_rcv_bytes,
+            fb_info_wire_roundtrips, isc_info_end };
+
+        att->getInfo(status, sizeof(info_options), info_options, sizeof(buffer), buffer);
+
+        bool result = false;
+
+        /* Extract the values returned in the result buffer. */
+        for (ISC_UCHAR* p = buffer; *p != isc_info_end; ) {
+            const unsigned char item = *p++;
+            const ISC_SHORT length = static_cast<ISC_SHORT>(portable_integer(p, 2));
+            p += 2;
+            switch (item) {
+            case fb_info_wire_out_packets:
+                stat.wire_out_packets = portable_integer(p, length);
+                result = true;
+                break;
+            case fb_info_wire_in_packets:
+                stat.wire_in_packets = portable_integer(p, length);
+                result = true;
+                break;
+            case fb_info_wire_out_bytes:
+                stat.wire_out_bytes = portable_integer(p, length);
+                result = true;
+                break;
+            case fb_info_wire_in_bytes:
+                stat.wire_in_bytes = portable_integer(p, length);
+                result = true;
+                break;
+            case fb_info_wire_snd_packets:
+                stat.wire_snd_packets = portable_integer(p, length);
+                result = true;
+                break;
+            case fb_info_wire_rcv_packets:
+                stat.wire_rcv_packets = portable_integer(p, length);
+                result = true;
+                break;
+            case fb_info_wire_snd_bytes:
+                stat.wire_snd_bytes = portable_integer(p, length);
+                result = true;
+                break;
+            case fb_info_wire_rcv_bytes:
+                stat.wire_rcv_bytes = portable_integer(p, length);
+                result = true;
+                break;
+            case fb_info_wire_roundtrips:
+                stat.wire_roundtrips = portable_integer(p, length);
+                result = true;
+                break;
+            default:
+                break;
+            }
+            p += length;
+        };
+        return result;
+    }
+
+    /// <summary>
+    /// Aggregate of all spans with the same label path.
+    /// Wire counters are summed over the spans that read them (sampled).
+    /// </summary>
+    struct SpanStat {
+        int64_t count = 0;
+        int64_t sampled = 0;
+        std::chrono::nanoseconds elapsed{ 0 };
+        FbWireStat wire{};
+    };
+
+    using SpanStats = std::unordered_map<std::string, SpanStat>;
+
+    namespace detail {
+
+        inline void merge(SpanStats& to, const SpanStats& from)
+        {
+            for (const auto& [path, stat] : from) {
+                auto& target = to[path];
+                target.count += stat.count;
+                target.sampled += stat.sampled;
+                target.elapsed += stat.elapsed;
+                target.wire += stat.wire;
+            }
+        }
+
+        struct Global {
+            std::mutex mutex;
+            // spans of finished threads
+            SpanStats retired;
+            unsigned sampleEvery = 0;
+        };
+
+        inline Global& global()
+        {
+            static Global instance;
+            return instance;
+        }
+
+        struct ThreadState {
+            SpanStats stats;
+            std::unordered_map<std::string, uint64_t> seen;
+            std::string path;
+            unsigned sampleEvery = 0;
+
+            ThreadState()
+            {
+                auto& g = global();
+                std::lock_guard<std::mutex> lock(g.mutex);
+                sampleEvery = g.sampleEvery;
+            }
+
+            ~ThreadState()
+            {
+                auto& g = global();
+                std::lock_guard<std::mutex> lock(g.mutex);
+                merge(g.retired, stats);
+            }
+        };
+
+        inline ThreadState& threadState()
+        {
+            thread_local ThreadState state;
+            return state;
+        }
+
+    } // namespace detail
+
+    /// <summary>
+    /// Sets how often sampled spans read the wire counters: 0 disables sampled spans,
+    /// 1 reads them in every span, N in every N-th span of each label path.
+    /// Call it before the measured threads start.
+    /// </summary>
+    inline void setSampleEvery(unsigned value)
+    {
+        auto& g = detail::global();
+        std::lock_guard<std::mutex> lock(g.mutex);
+        g.sampleEvery = value;
+        detail::threadState().sampleEvery = value;
+    }
+
+    inline unsigned sampleEvery()
+    {
+        auto& g = detail::global();
+        std::lock_guard<std::mutex> lock(g.mutex);
+        return g.sampleEvery;
+    }
+
+    /// <summary>
+    /// Cheap check for the hot path: reads the value cached by the calling thread without locking.
+    /// </summary>
+    inline bool samplingEnabled()
+    {
+        return detail::threadState().sampleEvery != 0;
+    }
+
+    enum class Mode {
+        // wire counters are read at both ends of every span
+        ALWAYS,
+        // the span is recorded only when sampling is enabled and reads the counters on its sampling turn
+        SAMPLED
+    };
+
+    class Span final
+    {
+    public:
+        struct Result {
+            // taken after the opening wire counter read
+            std::chrono::steady_clock::time_point start;
+            std::chrono::nanoseconds elapsed{ 0 };
+            FbWireStat wire{};
+            // false if the counters were not read or the client does not report them
+            bool wireValid = false;
+        };
+    private:
+        Firebird::ThrowStatusWrapper* m_status;
+        Firebird::IAttachment* m_att;
+        size_t m_parentPathLength = 0;
+        bool m_active = false;
+        bool m_readWire = false;
+        FbWireStat m_startStat{};
+        std::chrono::steady_clock::time_point m_start;
+    public:
+        Span(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, std::string_view label, Mode mode = Mode::SAMPLED)
+            : m_status(status)
+            , m_att(att)
+        {
+            auto& state = detail::threadState();
+            if (mode == Mode::SAMPLED && state.sampleEvery == 0) {
+                return;
+            }
+            m_active = true;
+            m_parentPathLength = state.path.size();
+            if (!state.path.empty()) {
+                state.path += '/';
+            }
+            state.path += label;
+            if (mode == Mode::ALWAYS || state.sampleEvery == 1) {
+                m_readWire = true;
+            }
+            else {
+                m_readWire = (state.seen[state.path]++ % state.sampleEvery) == 0;
+            }
+            if (m_readWire) {
+                try {
+                    m_readWire = getWireStat(m_status, m_att, m_startStat);
+                }
+                catch (...) {
+                    // the destructor does not run, restore the label path of the thread
+                    state.path.resize(m_parentPathLength);
+                    m_active = false;
+                    throw;
+                }
+            }
+            m_start = std::chrono::steady_clock::now();
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        ~Span()
+        {
+            try {
+                end();
+            }
+            catch (...) {
+                // the status wrapper throws, a destructor must not
+            }
+        }
+
+        bool active() const
+        {
+            return m_active;
+        }
+
+        /// <summary>
+        /// Ends the span before the end of the scope and returns its measurement.
+        /// Further calls return an empty result.
+        /// </summary>
+        Result end()
+        {
+            Result result;
+            if (!m_active) {
+                return result;
+            }
+            m_active = false;
+            result.start = m_start;
+            result.elapsed = std::chrono::steady_clock::now() - m_start;
+            auto& state = detail::threadState();
+            auto& stat = state.stats[state.path];
+            ++stat.count;
+            stat.elapsed += result.elapsed;
+            state.path.resize(m_parentPathLength);
+            if (m_readWire) {
+                FbWireStat endStat{};
+                if (getWireStat(m_status, m_att, endStat)) {
+                    result.wire = endStat - m_startStat;
+                    result.wireValid = true;
+                    ++stat.sampled;
+                    stat.wire += result.wire;
+                }
+            }
+            return result;
+        }
+    };
+
+    /// <summary>
+    /// Aggregates of finished threads and of the calling thread, sorted by label path.
+    /// Spans of other running threads are included after those threads end.
+    /// </summary>
+    inline std::vector<std::pair<std::string, SpanStat>> snapshot()
+    {
+        SpanStats all;
+        {
+            auto& g = detail::global();
+            std::lock_guard<std::mutex> lock(g.mutex);
+            all = g.retired;
+        }
+        detail::merge(all, detail::threadState().stats);
+        std::vector<std::pair<std::string, SpanStat>> result(all.begin(), all.end());
+        std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        return result;
+    }
+
+    /// <summary>
+    /// Clears the aggregates of finished threads and of the calling thread.
+    /// </summary>
+    inline void reset()
+    {
+        {
+            auto& g = detail::global();
+            std::lock_guard<std::mutex> lock(g.mutex);
+            g.retired.clear();
+        }
+        auto& state = detail::threadState();
+        state.stats.clear();
+        state.seen.clear();
+    }
+
+    /// <summary>
+    /// Prints count, time, and roundtrips and received bytes per sampled span for each label path.
+    /// </summary>
+    inline void report(std::ostream& out)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+
+        out << std::format("  {:<64} {:>10} {:>10} {:>12} {:>10} {:>12} {:>12}",
+            "span", "count", "sampled", "time, ms", "avg, us", "avg rt", "avg bytes") << std::endl;
+        for (const auto& [path, stat] : snapshot()) {
+            const auto total = duration_cast<microseconds>(stat.elapsed).count();
+            const double sampled = static_cast<double>(std::max<int64_t>(stat.sampled, 1));
+            out << std::format("  {:<64} {:>10} {:>10} {:>12.1f} {:>10.1f} {:>12.2f} {:>12.1f}",
+                path, stat.count, stat.sampled, total / 1000.0,
+                static_cast<double>(total) / static_cast<double>(std::max<int64_t>(stat.count, 1)),
+                static_cast<double>(stat.wire.wire_roundtrips) / sampled,
+                static_cast<double>(stat.wire.wire_in_bytes) / sampled) << std::endl;
+        }
+    }
+
+} // namespace WireSpans
+
+#endif // WIRE_SPANS_H
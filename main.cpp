@@ -1,17 +1,43 @@
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <chrono>
+#include <cmath>
+#include <format>
+#include <functional>
+#include <memory>
+#include <numeric>
 #include <optional>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include <firebird/Interface.h>
 #include <firebird/Message.h>
 
 #include "FBAutoPtr.h"
+#include "AllocTracker.h"
+#include "BlobCache.h"
+#include "PerfCounters.h"
+#include "ColumnarResult.h"
+#include "FetchRecording.h"
+#include "Lz4Block.h"
+#include "WireSpans.h"
 
 namespace {
 
     static Firebird::IMaster* master = Firebird::fb_get_master_interface();
 
+    using WireSpans::FbWireStat;
+    using WireSpans::getWireStat;
+    using WireSpans::portable_integer;
+
     constexpr unsigned int MAX_SEGMENT_SIZE = 65535;
     constexpr size_t MEGABYTE = 1024 * 1024;
 
@@ -80,16 +106,83 @@ SELECT
 FROM BLOB_TEST
 )";
 
-    struct FbWireStat {
-        int64_t wire_out_packets;
-        int64_t wire_in_packets; 
-        int64_t wire_out_bytes;
-        int64_t wire_in_bytes;
-        int64_t wire_snd_packets;
-        int64_t wire_rcv_packets;
-        int64_t wire_snd_bytes;
-        int64_t wire_rcv_bytes;
-        int64_t wire_roundtrips;
+    constexpr const char* SQL_LENGTH_READ = R"(
+SELECT
+  ID,
+  OCTET_LENGTH(CONTENT) AS CONTENT_LENGTH
+FROM BLOB_TEST
+)";
+
+    constexpr const char* SQL_BATCH_VARCHAR_READ = R"(
+SELECT
+  ID,
+  CAST(CONTENT AS VARCHAR(8191) CHARACTER SET OCTETS) AS SHORT_CONTENT
+FROM BLOB_TEST
+WHERE ID IN )";
+
+    constexpr const char* SQL_BATCH_BLOB_READ = R"(
+SELECT
+  ID,
+  CONTENT
+FROM BLOB_TEST
+WHERE ID IN )";
+
+    // the {} placeholder is replaced by the chunk source aliased as C
+    constexpr const char* SQL_CHUNKED_READ = R"(
+SELECT
+  C.ID,
+  C.CHUNK
+FROM {}
+ORDER BY C.ID, C.CHUNK_NO
+)";
+
+    constexpr const char* SQL_MON_STAT = R"(
+SELECT
+  IO.MON$PAGE_READS,
+  IO.MON$PAGE_WRITES,
+  IO.MON$PAGE_FETCHES,
+  IO.MON$PAGE_MARKS,
+  REC.MON$RECORD_SEQ_READS,
+  REC.MON$RECORD_IDX_READS,
+  REC.MON$RECORD_INSERTS,
+  REC.MON$RECORD_UPDATES,
+  REC.MON$RECORD_DELETES,
+  REC.MON$RECORD_BACKOUTS,
+  REC.MON$RECORD_PURGES,
+  REC.MON$RECORD_EXPUNGES,
+  REC.MON$BACKVERSION_READS,
+  REC.MON$FRAGMENT_READS
+FROM MON$ATTACHMENTS A
+JOIN MON$IO_STATS IO ON IO.MON$STAT_ID = A.MON$STAT_ID
+JOIN MON$RECORD_STATS REC ON REC.MON$STAT_ID = A.MON$STAT_ID
+WHERE A.MON$ATTACHMENT_ID = ?
+)";
+
+    struct FbMonStat {
+        int64_t page_reads;
+        int64_t page_writes;
+        int64_t page_fetches;
+        int64_t page_marks;
+        int64_t record_seq_reads;
+        int64_t record_idx_reads;
+        int64_t record_inserts;
+        int64_t record_updates;
+        int64_t record_deletes;
+        int64_t record_backouts;
+        int64_t record_purges;
+        int64_t record_expunges;
+        int64_t backversion_reads;
+        int64_t fragment_reads;
+    };
+
+    struct TestResult {
+        std::chrono::microseconds elapsed;
+        int64_t record_count;
+        FbWireStat wire;
+        // BLOBs opened by the test
+        int64_t blob_count{ 0 };
+        // process CPU time, filled by the caller of the test
+        std::chrono::microseconds cpu{ 0 };
     };
 
     struct FbBlobInfo {
@@ -99,6 +192,8 @@ FROM BLOB_TEST
         short blob_type;
     };
 
+    constexpr unsigned char DEFAULT_READ_TPB[] = { isc_tpb_version1, isc_tpb_read, isc_tpb_read_committed, isc_tpb_read_consistency };
+
     enum class Read_Blob_Kind { ALL_BLOB, SHORT_BLOB, LONG_BLOB };
 
     const char* sql_for_blob_read_kind(Read_Blob_Kind kind)
@@ -147,88 +242,6 @@ FROM BLOB_TEST
         return s;
     }
 
-    int64_t portable_integer(const unsigned char* ptr, short length)
-    {
-        if (!ptr || length <= 0 || length > 8)
-            return 0;
-
-        int64_t value = 0;
-        int shift = 0;
-
-        while (--length > 0) {
-            value += (static_cast<int64_t>(*ptr++)) << shift;
-            shift += 8;
-        }
-
-        value += (static_cast<int64_t>(static_cast<char>(*ptr))) << shift;
-
-        return value;
-    }
-
-    bool getWireStat(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, FbWireStat& stat)
-    {
-        ISC_UCHAR buffer[1024];
-        const unsigned char info_options[] = {
-            fb_info_wire_out_packets, fb_info_wire_in_packets,
-            fb_info_wire_out_bytes, fb_info_wire_in_bytes,
-            fb_info_wire_snd_packets, fb_info_wire_rcv_packets,
-            fb_info_wire_snd_bytes, fb_info_wire_rcv_bytes,
-            fb_info_wire_roundtrips, isc_info_end };
-
-        att->getInfo(status, sizeof(info_options), info_options, sizeof(buffer), buffer);
-
-        bool result = false;
-
-        /* Extract the values returned in the result buffer. */
-        for (ISC_UCHAR* p = buffer; *p != isc_info_end; ) {
-            const unsigned char item = *p++;
-            const ISC_SHORT length = static_cast<ISC_SHORT>(portable_integer(p, 2));
-            p += 2;
-            switch (item) {
-            case fb_info_wire_out_packets:
-                stat.wire_out_packets = portable_integer(p, length);
-                result = true;
-                break;
-            case fb_info_wire_in_packets:
-                stat.wire_in_packets = portable_integer(p, length);
-                result = true;
-                break;
-            case fb_info_wire_out_bytes:
-                stat.wire_out_bytes = portable_integer(p, length);
-                result = true;
-                break;
-            case fb_info_wire_in_bytes:
-                stat.wire_in_bytes = portable_integer(p, length);
-                result = true;
-                break;
-            case fb_info_wire_snd_packets:
-                stat.wire_snd_packets = portable_integer(p, length);
-                result = true;
-                break;
-            case fb_info_wire_rcv_packets:
-                stat.wire_rcv_packets = portable_integer(p, length);
-                result = true;
-                break;
-            case fb_info_wire_snd_bytes:
-                stat.wire_snd_bytes = portable_integer(p, length);
-                result = true;
-                break;
-            case fb_info_wire_rcv_bytes:
-                stat.wire_rcv_bytes = portable_integer(p, length);
-                result = true;
-                break;
-            case fb_info_wire_roundtrips:
-                stat.wire_roundtrips = portable_integer(p, length);
-                result = true;
-                break;
-            default:
-                break;
-            }
-            p += length;
-        };
-        return result;
-    }
-
     void getBlobStat(Firebird::ThrowStatusWrapper* status, Firebird::IBlob* blob, FbBlobInfo& stat)
     {
         ISC_UCHAR buffer[1024];
@@ -262,185 +275,627 @@ FROM BLOB_TEST
         };
     }
 
-    class WireStartCollector
+    int64_t getAttachmentId(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att)
     {
-    private:
-        FbWireStat startStat;
-        FbWireStat endStat;
-        bool enable = true;
-    public:
-        WireStartCollector() {
-            memset(&startStat, 0, sizeof(startStat));
-            memset(&endStat, 0, sizeof(endStat));
-        }
-
-        void startStatCollect(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att)
-        {
-            enable = enable && getWireStat(status, att, startStat);
-        }
+        ISC_UCHAR buffer[64];
+        const unsigned char info_options[] = { isc_info_attachment_id, isc_info_end };
 
-        void endStatCollect(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att)
-        {
-            enable = enable && getWireStat(status, att, endStat);
-        }
+        att->getInfo(status, sizeof(info_options), info_options, sizeof(buffer), buffer);
 
-        void printWireStat();
-    };
+        int64_t attachmentId = 0;
+        for (ISC_UCHAR* p = buffer; *p != isc_info_end; ) {
+            const unsigned char item = *p++;
+            const ISC_SHORT length = static_cast<ISC_SHORT>(portable_integer(p, 2));
+            p += 2;
+            if (item == isc_info_attachment_id) {
+                attachmentId = portable_integer(p, length);
+            }
+            p += length;
+        };
+        return attachmentId;
+    }
 
+    /// <summary>
+    /// Returns the snapshot number of the transaction, or 0 if the server does not report it.
+    /// </summary>
+    int64_t getSnapshotNumber(Firebird::ThrowStatusWrapper* status, Firebird::ITransaction* tra)
+    {
+        ISC_UCHAR buffer[64];
+        const unsigned char info_options[] = { fb_info_tra_snapshot_number, isc_info_end };
 
+        tra->getInfo(status, sizeof(info_options), info_options, sizeof(buffer), buffer);
 
-    void WireStartCollector::printWireStat()
-    {
-        if (!enable) {
-            return;
-        }
-        std::cout << "Wire logical statistics:" << std::endl;
-        std::cout << "  send packets = " << (endStat.wire_out_packets - startStat.wire_out_packets) << std::endl;
-        std::cout << "  recv packets = " << (endStat.wire_in_packets - startStat.wire_in_packets) << std::endl;
-        std::cout << "  send bytes = " << (endStat.wire_out_bytes - startStat.wire_out_bytes) << std::endl;
-        std::cout << "  recv bytes = " << (endStat.wire_in_bytes - startStat.wire_in_bytes) << std::endl;
-        std::cout << "Wire physical statistics:" << std::endl;
-        std::cout << "  send packets = " << (endStat.wire_snd_packets - startStat.wire_snd_packets) << std::endl;
-        std::cout << "  recv packets = " << (endStat.wire_rcv_packets - startStat.wire_rcv_packets) << std::endl;
-        std::cout << "  send bytes = " << (endStat.wire_snd_bytes - startStat.wire_snd_bytes) << std::endl;
-        std::cout << "  recv bytes = " << (endStat.wire_rcv_bytes - startStat.wire_rcv_bytes) << std::endl;
-        std::cout << "  roundtrips = " << (endStat.wire_roundtrips - startStat.wire_roundtrips) << std::endl;
+        int64_t snapshotNumber = 0;
+        for (ISC_UCHAR* p = buffer; *p != isc_info_end; ) {
+            const unsigned char item = *p++;
+            if (item == isc_info_error || item == isc_info_truncated) {
+                break;
+            }
+            const ISC_SHORT length = static_cast<ISC_SHORT>(portable_integer(p, 2));
+            p += 2;
+            if (item == fb_info_tra_snapshot_number) {
+                snapshotNumber = portable_integer(p, length);
+            }
+            p += length;
+        };
+        return snapshotNumber;
     }
 
     /// <summary>
-    /// Warming up the cache
+    /// Reads MON$IO_STATS and MON$RECORD_STATS of the tested attachment
+    /// through a separate monitoring attachment, so the queries do not
+    /// affect the wire statistics of the tested one.
     /// </summary>
-    /// <param name="status">Status</param>
-    /// <param name="att">Database attachment</param>
-    void cacheWarmingUp(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att)
+    class MonStatSource final
     {
-        using std::chrono::duration_cast;
-        using std::chrono::high_resolution_clock;
-        using std::chrono::milliseconds;
+    private:
+        Firebird::AutoRelease<Firebird::IAttachment> m_att;
+        Firebird::AutoRelease<Firebird::IStatement> m_stmt;
+        int64_t m_attachmentId;
+    public:
+        MonStatSource(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* monAtt, int64_t attachmentId)
+            : m_att(monAtt)
+            , m_attachmentId(attachmentId)
+        {
+            try {
+                unsigned char tpb[] = { isc_tpb_version1, isc_tpb_read, isc_tpb_concurrency };
+                Firebird::AutoRelease<Firebird::ITransaction> tra = m_att->startTransaction(status, std::size(tpb), tpb);
+                m_stmt = m_att->prepare(status, tra, 0, SQL_MON_STAT, 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+                tra->commit(status);
+                tra.release();
+            }
+            catch (...) {
+                // the destructor does not run
+                detachQuietly();
+                throw;
+            }
+        }
 
-        unsigned char tpb[] = { isc_tpb_version1, isc_tpb_read, isc_tpb_read_committed, isc_tpb_read_consistency };
+        MonStatSource(const MonStatSource&) = delete;
+        MonStatSource& operator=(const MonStatSource&) = delete;
 
-        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, std::size(tpb), tpb);
+        ~MonStatSource()
+        {
+            // error path: a test threw before detach(), the attachment must not be left on the server
+            detachQuietly();
+        }
 
-        std::cout << "SQL:" << std::endl << SQL_CACHE_WARMING << std::endl;
+        bool getMonStat(Firebird::ThrowStatusWrapper* status, FbMonStat& stat);
 
-        Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, SQL_CACHE_WARMING, 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+        void detach(Firebird::ThrowStatusWrapper* status)
+        {
+            if (m_stmt) {
+                m_stmt->free(status);
+                m_stmt.release();
+            }
+            m_att->detach(status);
+            m_att.release();
+        }
+    private:
+        void detachQuietly()
+        {
+            if (!m_att) {
+                return;
+            }
+            Firebird::AutoDispose<Firebird::IStatus> st = master->getStatus();
+            Firebird::ThrowStatusWrapper status(st);
+            // the status wrapper throws, a destructor must not
+            if (m_stmt) {
+                try {
+                    m_stmt->free(&status);
+                    m_stmt.release();
+                }
+                catch (...) {
+                }
+            }
+            try {
+                m_att->detach(&status);
+                m_att.release();
+            }
+            catch (...) {
+            }
+        }
+    };
 
-        Firebird::AutoRelease<Firebird::IMessageMetadata> inMetadata = stmt->getInputMetadata(status);
-        Firebird::AutoRelease<Firebird::IMessageMetadata> outMetadata = stmt->getOutputMetadata(status);
+    bool MonStatSource::getMonStat(Firebird::ThrowStatusWrapper* status, FbMonStat& stat)
+    {
+        // the monitoring snapshot is taken once per transaction, so each call needs a new one
+        unsigned char tpb[] = { isc_tpb_version1, isc_tpb_read, isc_tpb_concurrency };
 
-        auto t0 = high_resolution_clock::now();
+        Firebird::AutoRelease<Firebird::ITransaction> tra = m_att->startTransaction(status, std::size(tpb), tpb);
 
-        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, inMetadata, nullptr, outMetadata, 0);
+        FB_MESSAGE(InMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, attachment_id)
+        ) in(status, master);
+
+        in->attachment_idNull = false;
+        in->attachment_id = m_attachmentId;
 
         FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
-            (FB_BIGINT, MAX_CHAR_LENGTH)
+            (FB_BIGINT, page_reads)
+            (FB_BIGINT, page_writes)
+            (FB_BIGINT, page_fetches)
+            (FB_BIGINT, page_marks)
+            (FB_BIGINT, record_seq_reads)
+            (FB_BIGINT, record_idx_reads)
+            (FB_BIGINT, record_inserts)
+            (FB_BIGINT, record_updates)
+            (FB_BIGINT, record_deletes)
+            (FB_BIGINT, record_backouts)
+            (FB_BIGINT, record_purges)
+            (FB_BIGINT, record_expunges)
+            (FB_BIGINT, backversion_reads)
+            (FB_BIGINT, fragment_reads)
         ) out(status, master);
 
-        int64_t s = 0;
+        Firebird::AutoRelease<Firebird::IResultSet> rs = m_stmt->openCursor(status, tra, in.getMetadata(), in.getData(), out.getMetadata(), 0);
+
+        bool result = false;
         if (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
-            s = out->MAX_CHAR_LENGTH;
+            stat.page_reads = out->page_reads;
+            stat.page_writes = out->page_writes;
+            stat.page_fetches = out->page_fetches;
+            stat.page_marks = out->page_marks;
+            stat.record_seq_reads = out->record_seq_reads;
+            stat.record_idx_reads = out->record_idx_reads;
+            stat.record_inserts = out->record_inserts;
+            stat.record_updates = out->record_updates;
+            stat.record_deletes = out->record_deletes;
+            stat.record_backouts = out->record_backouts;
+            stat.record_purges = out->record_purges;
+            stat.record_expunges = out->record_expunges;
+            stat.backversion_reads = out->backversion_reads;
+            stat.fragment_reads = out->fragment_reads;
+            result = true;
         }
-        auto t1 = high_resolution_clock::now();
-        auto elapsed = duration_cast<milliseconds>(t1 - t0);
-        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
-        std::cout << "Max char length: " << s << std::endl;
 
         rs->close(status);
         rs.release();
 
-        stmt->free(status);
-        stmt.release();
-
         tra->commit(status);
         tra.release();
+
+        return result;
     }
 
-    /// <summary>
-    /// Test reading only identifiers BLOB.
-    /// </summary>
-    /// <param name="status">Status</param>
-    /// <param name="att">Database attachment</param>
-    /// <param name="readBlobKind">What types of blobs to read: all, short, long</param>
-    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
-    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
-    void testReadBlobId(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Read_Blob_Kind readBlobKind, 
-        std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {})
-    {
-        using std::chrono::duration_cast;
-        using std::chrono::high_resolution_clock;
-        using std::chrono::milliseconds;
+    // monitoring source of the tested attachment, set only with --mon-stat
+    MonStatSource* monStatSource = nullptr;
 
-        unsigned char tpb[] = { isc_tpb_version1, isc_tpb_read, isc_tpb_read_committed, isc_tpb_read_consistency };
+    // label of the root span of the running test, set by printTestHeader
+    std::string currentScenario = "test";
 
-        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, std::size(tpb), tpb);
+    class WireStartCollector
+    {
+    private:
+        std::optional<WireSpans::Span> span;
+        FbWireStat wireStat;
+        FbMonStat monStartStat;
+        FbMonStat monEndStat;
+        AllocTracker::Counters allocStartStat;
+        AllocTracker::Counters allocEndStat;
+        AllocTracker::HeapStat heapStartStat;
+        AllocTracker::HeapStat heapEndStat;
+        PerfCounters::Values perfStartStat;
+        PerfCounters::Values perfEndStat;
+        bool enable = true;
+        bool monEnable = false;
+        bool allocEnable = false;
+        bool perfEnable = false;
+    public:
+        WireStartCollector() {
+            memset(&wireStat, 0, sizeof(wireStat));
+            memset(&monStartStat, 0, sizeof(monStartStat));
+            memset(&monEndStat, 0, sizeof(monEndStat));
+            memset(&allocStartStat, 0, sizeof(allocStartStat));
+            memset(&allocEndStat, 0, sizeof(allocEndStat));
+            memset(&heapStartStat, 0, sizeof(heapStartStat));
+            memset(&heapEndStat, 0, sizeof(heapEndStat));
+            monEnable = (monStatSource != nullptr);
+            allocEnable = AllocTracker::enabled();
+            perfEnable = PerfCounters::isOpen();
+        }
 
-        std::string sql = sql_for_blob_read_kind(readBlobKind);
-        if (limit_rows.has_value()) {
-            sql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
+        /// <summary>
+        /// Takes the MON$ snapshot before the test. Each snapshot is a transaction on the monitoring
+        /// attachment, so it is called before the start of the timed interval.
+        /// </summary>
+        void beginMonStat(Firebird::ThrowStatusWrapper* status)
+        {
+            monEnable = monEnable && monStatSource->getMonStat(status, monStartStat);
         }
-        std::cout << "SQL:" << std::endl << sql << std::endl;
 
-        Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, sql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+        /// <summary>
+        /// Takes the MON$ snapshot after the end of the timed interval.
+        /// </summary>
+        void endMonStat(Firebird::ThrowStatusWrapper* status)
+        {
+            monEnable = monEnable && monStatSource->getMonStat(status, monEndStat);
+        }
 
-        if (stmt->cloopVTable->version >= stmt->VERSION) {
-            if (max_inline_blob_size.has_value()) {
-                stmt->setMaxInlineBlobSize(status, max_inline_blob_size.value());
+        void startStatCollect(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att)
+        {
+            if (allocEnable) {
+                AllocTracker::resetPeak();
+                allocStartStat = AllocTracker::snapshot();
+                heapStartStat = AllocTracker::heapStat();
+            }
+            if (perfEnable) {
+                perfStartStat = PerfCounters::read();
+            }
+            if (enable) {
+                span.emplace(status, att, currentScenario, WireSpans::Mode::ALWAYS);
             }
-            std::cout << std::format("MaxInlineBlobSize = {}", stmt->getMaxInlineBlobSize(status)) << std::endl;
         }
 
-        Firebird::AutoRelease<Firebird::IMessageMetadata> inMetadata = stmt->getInputMetadata(status);
-        Firebird::AutoRelease<Firebird::IMessageMetadata> outMetadata = stmt->getOutputMetadata(status);
+        void endStatCollect()
+        {
+            if (span) {
+                const auto result = span->end();
+                enable = result.wireValid;
+                wireStat = result.wire;
+                span.reset();
+            }
+            if (perfEnable) {
+                perfEndStat = PerfCounters::read();
+            }
+            if (allocEnable) {
+                allocEndStat = AllocTracker::snapshot();
+                heapEndStat = AllocTracker::heapStat();
+            }
+        }
 
-        WireStartCollector wireStatCollector;
+        FbWireStat getWireStatDelta() const;
 
-        auto t0 = high_resolution_clock::now();
+        void printWireStat();
+    private:
+        void printMonStat();
 
-        wireStatCollector.startStatCollect(status, att);
+        void printAllocStat();
 
-        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, inMetadata, nullptr, outMetadata, 0);
+        void printPerfStat();
+    };
 
-        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
-            (FB_BIGINT, id)
-            (FB_BLOB, content)
-        ) out(status, master);
 
-        int64_t max_id = 0;
-        int64_t record_count = 0;
-        while (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
-            max_id = std::max<int64_t>(max_id, out->id);
-            ++record_count;
-        }
-        wireStatCollector.endStatCollect(status, att);
 
-        auto t1 = high_resolution_clock::now();
-        auto elapsed = duration_cast<milliseconds>(t1 - t0);
-        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
-        std::cout << "Max id: " << max_id << std::endl;
-        std::cout << "Record count: " << record_count << std::endl;
-        wireStatCollector.printWireStat();
+    FbWireStat WireStartCollector::getWireStatDelta() const
+    {
+        FbWireStat delta;
+        std::memset(&delta, 0, sizeof(delta));
+        return enable ? wireStat : delta;
+    }
 
-        rs->close(status);
-        rs.release();
+    void WireStartCollector::printWireStat()
+    {
+        if (!enable) {
+            return;
+        }
+        std::cout << "Wire logical statistics:" << std::endl;
+        std::cout << "  send packets = " << wireStat.wire_out_packets << std::endl;
+        std::cout << "  recv packets = " << wireStat.wire_in_packets << std::endl;
+        std::cout << "  send bytes = " << wireStat.wire_out_bytes << std::endl;
+        std::cout << "  recv bytes = " << wireStat.wire_in_bytes << std::endl;
+        std::cout << "Wire physical statistics:" << std::endl;
+        std::cout << "  send packets = " << wireStat.wire_snd_packets << std::endl;
+        std::cout << "  recv packets = " << wireStat.wire_rcv_packets << std::endl;
+        std::cout << "  send bytes = " << wireStat.wire_snd_bytes << std::endl;
+        std::cout << "  recv bytes = " << wireStat.wire_rcv_bytes << std::endl;
+        std::cout << "  roundtrips = " << wireStat.wire_roundtrips << std::endl;
+        printMonStat();
+        printAllocStat();
+        printPerfStat();
+    }
 
-        stmt->free(status);
-        stmt.release();
+    void WireStartCollector::printPerfStat()
+    {
+        if (!perfEnable) {
+            return;
+        }
+        int64_t delta[PerfCounters::COUNTER_COUNT];
+        std::cout << "Client CPU counters:" << std::endl;
+        for (int i = 0; i < PerfCounters::COUNTER_COUNT; i++) {
+            const bool available = perfStartStat.value[i] >= 0 && perfEndStat.value[i] >= 0;
+            delta[i] = available ? perfEndStat.value[i] - perfStartStat.value[i] : -1;
+            std::cout << "  " << PerfCounters::counterName(static_cast<PerfCounters::Counter>(i)) << " = ";
+            if (available) {
+                std::cout << delta[i] << std::endl;
+            }
+            else {
+                std::cout << "n/a" << std::endl;
+            }
+        }
+        const int64_t cycles = delta[PerfCounters::CYCLES];
+        const int64_t instructions = delta[PerfCounters::INSTRUCTIONS];
+        if (cycles > 0 && instructions >= 0) {
+            std::cout << std::format("  IPC = {:.2f}", static_cast<double>(instructions) / static_cast<double>(cycles)) << std::endl;
+        }
+        const int64_t in_bytes = wireStat.wire_in_bytes;
+        const int64_t rcv_bytes = wireStat.wire_rcv_bytes;
+        if (cycles >= 0 && enable && in_bytes > 0 && rcv_bytes > 0) {
+            std::cout << std::format("  cycles per received byte = {:.2f}", static_cast<double>(cycles) / static_cast<double>(in_bytes)) << std::endl;
+            std::cout << std::format("  cycles per received wire byte = {:.2f}", static_cast<double>(cycles) / static_cast<double>(rcv_bytes)) << std::endl;
+        }
+    }
 
-        tra->commit(status);
-        tra.release();
+    void WireStartCollector::printAllocStat()
+    {
+        if (!allocEnable) {
+            return;
+        }
+        std::cout << "Client memory statistics:" << std::endl;
+        std::cout << "  allocations = " << (allocEndStat.alloc_count - allocStartStat.alloc_count) << std::endl;
+        std::cout << "  deallocations = " << (allocEndStat.free_count - allocStartStat.free_count) << std::endl;
+        std::cout << "  allocated bytes = " << (allocEndStat.alloc_bytes - allocStartStat.alloc_bytes) << std::endl;
+        std::cout << "  peak live bytes = " << (allocEndStat.peak_live_bytes - allocStartStat.live_bytes) << std::endl;
+        if (heapStartStat.available && heapEndStat.available) {
+            std::cout << "  heap in use delta = " << (heapEndStat.in_use - heapStartStat.in_use) << std::endl;
+        }
     }
 
-    /// <summary>
-    /// Test reading BLOBs.
+    void WireStartCollector::printMonStat()
+    {
+        if (!monEnable) {
+            return;
+        }
+        std::cout << "Server I/O statistics:" << std::endl;
+        std::cout << "  page reads = " << (monEndStat.page_reads - monStartStat.page_reads) << std::endl;
+        std::cout << "  page writes = " << (monEndStat.page_writes - monStartStat.page_writes) << std::endl;
+        std::cout << "  page fetches = " << (monEndStat.page_fetches - monStartStat.page_fetches) << std::endl;
+        std::cout << "  page marks = " << (monEndStat.page_marks - monStartStat.page_marks) << std::endl;
+        std::cout << "Server record statistics:" << std::endl;
+        std::cout << "  sequential reads = " << (monEndStat.record_seq_reads - monStartStat.record_seq_reads) << std::endl;
+        std::cout << "  indexed reads = " << (monEndStat.record_idx_reads - monStartStat.record_idx_reads) << std::endl;
+        std::cout << "  inserts = " << (monEndStat.record_inserts - monStartStat.record_inserts) << std::endl;
+        std::cout << "  updates = " << (monEndStat.record_updates - monStartStat.record_updates) << std::endl;
+        std::cout << "  deletes = " << (monEndStat.record_deletes - monStartStat.record_deletes) << std::endl;
+        std::cout << "  backouts = " << (monEndStat.record_backouts - monStartStat.record_backouts) << std::endl;
+        std::cout << "  purges = " << (monEndStat.record_purges - monStartStat.record_purges) << std::endl;
+        std::cout << "  expunges = " << (monEndStat.record_expunges - monStartStat.record_expunges) << std::endl;
+        std::cout << "  back version reads = " << (monEndStat.backversion_reads - monStartStat.backversion_reads) << std::endl;
+        std::cout << "  fragment reads = " << (monEndStat.fragment_reads - monStartStat.fragment_reads) << std::endl;
+    }
+
+    enum class TraceEvent { FETCH, BLOB_OPEN, BLOB_READ, BLOB_CLOSE };
+
+    const char* trace_event_name(TraceEvent event)
+    {
+        switch (event)
+        {
+        case TraceEvent::FETCH:
+            return "fetch";
+        case TraceEvent::BLOB_OPEN:
+            return "blob_open";
+        case TraceEvent::BLOB_READ:
+            return "blob_read";
+        case TraceEvent::BLOB_CLOSE:
+            return "blob_close";
+        default:
+            return "unknown";
+        }
+    }
+
+    /// <summary>
+    /// Writes a CSV timeline with one line per fetch and per BLOB open/read/close:
+    /// start time, duration and wire counter deltas of the call.
+    /// Calls that block on the network show up as lines with a non-zero roundtrip delta.
+    /// </summary>
+    class WireTracer final
+    {
+    private:
+        std::ofstream m_out;
+        std::chrono::steady_clock::time_point m_origin;
+        std::string m_scenario;
+        int64_t m_seq = 0;
+        int64_t m_row = 0;
+    public:
+        explicit WireTracer(const std::string& fileName)
+            : m_out(fileName, std::ios::out | std::ios::trunc)
+            , m_origin(std::chrono::steady_clock::now())
+        {
+            if (!m_out) {
+                throw std::runtime_error("Cannot open trace file " + fileName);
+            }
+            m_out << "scenario,seq,event,row,start_us,duration_us,"
+                "out_packets,in_packets,out_bytes,in_bytes,"
+                "snd_packets,rcv_packets,snd_bytes,rcv_bytes,roundtrips\n";
+        }
+
+        void beginScenario(const std::string& scenario)
+        {
+            m_scenario = scenario;
+            m_row = 0;
+        }
+
+        void write(TraceEvent event, const WireSpans::Span::Result& call);
+    };
+
+    void WireTracer::write(TraceEvent event, const WireSpans::Span::Result& call)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+
+        const auto& stat = call.wire;
+
+        if (event == TraceEvent::FETCH) {
+            ++m_row;
+        }
+        m_out << m_scenario << ',' << ++m_seq << ',' << trace_event_name(event) << ',' << m_row << ','
+            << duration_cast<microseconds>(call.start - m_origin).count() << ','
+            << duration_cast<microseconds>(call.elapsed).count() << ','
+            << stat.wire_out_packets << ','
+            << stat.wire_in_packets << ','
+            << stat.wire_out_bytes << ','
+            << stat.wire_in_bytes << ','
+            << stat.wire_snd_packets << ','
+            << stat.wire_rcv_packets << ','
+            << stat.wire_snd_bytes << ','
+            << stat.wire_rcv_bytes << ','
+            << stat.wire_roundtrips << '\n';
+    }
+
+    // timeline trace, set only with --trace
+    WireTracer* wireTracer = nullptr;
+
+    /// <summary>
+    /// Runs a client call inside a span labeled with the event name. The span reads
+    /// the wire counters for every call when the timeline trace is written, otherwise it is sampled.
+    /// </summary>
+    template <typename Func>
+    auto traceCall(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, TraceEvent event, Func&& func)
+    {
+        if (!wireTracer && !WireSpans::samplingEnabled()) {
+            return func();
+        }
+        WireSpans::Span span(status, att, trace_event_name(event), wireTracer ? WireSpans::Mode::ALWAYS : WireSpans::Mode::SAMPLED);
+        if constexpr (std::is_void_v<decltype(func())>) {
+            func();
+            const auto call = span.end();
+            if (wireTracer) {
+                wireTracer->write(event, call);
+            }
+        }
+        else {
+            auto result = func();
+            const auto call = span.end();
+            if (wireTracer) {
+                wireTracer->write(event, call);
+            }
+            return result;
+        }
+    }
+
+    int tracedFetchNext(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Firebird::IResultSet* rs, void* buffer)
+    {
+        return traceCall(status, att, TraceEvent::FETCH, [&] { return rs->fetchNext(status, buffer); });
+    }
+
+    Firebird::IBlob* tracedOpenBlob(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Firebird::ITransaction* tra, ISC_QUAD* blobId)
+    {
+        return traceCall(status, att, TraceEvent::BLOB_OPEN, [&] { return att->openBlob(status, tra, blobId, 0, nullptr); });
+    }
+
+    std::string tracedReadBlob(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Firebird::IBlob* blob)
+    {
+        return traceCall(status, att, TraceEvent::BLOB_READ, [&] { return readBlob(status, blob); });
+    }
+
+    void tracedCloseBlob(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Firebird::IBlob* blob)
+    {
+        traceCall(status, att, TraceEvent::BLOB_CLOSE, [&] { blob->close(status); });
+    }
+
+    /// <summary>
+    /// Breakdown of BLOB read cost by size class.
+    /// A BLOB is counted as inline when its open, read and close took no roundtrips.
+    /// </summary>
+    class BlobSizeBuckets final
+    {
+    public:
+        struct Bucket {
+            const char* name;
+            size_t upper_bound;
+            int64_t count = 0;
+            int64_t inline_count = 0;
+            int64_t bytes = 0;
+            int64_t roundtrips = 0;
+            std::chrono::nanoseconds elapsed{ 0 };
+        };
+
+    private:
+        std::vector<Bucket> m_buckets;
+    public:
+        BlobSizeBuckets()
+            : m_buckets{
+                { "<= 1 KB", 1024 },
+                { "<= 8 KB", 8 * 1024 },
+                { "<= 32 KB", 32 * 1024 },
+                { "<= 64 KB", 64 * 1024 },
+                { "> 64 KB", SIZE_MAX } }
+        {}
+
+        void add(const WireSpans::Span::Result& read, size_t size)
+        {
+            auto bucket = std::find_if(m_buckets.begin(), m_buckets.end(),
+                [size](const Bucket& b) { return size <= b.upper_bound; });
+            const int64_t roundtrips = read.wire.wire_roundtrips;
+            ++bucket->count;
+            if (roundtrips == 0) {
+                ++bucket->inline_count;
+            }
+            bucket->bytes += static_cast<int64_t>(size);
+            bucket->roundtrips += roundtrips;
+            bucket->elapsed += read.elapsed;
+        }
+
+        void print() const;
+    };
+
+    void BlobSizeBuckets::print() const
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+
+        std::cout << "BLOB size buckets:" << std::endl;
+        std::cout << std::format("  {:<10} {:>10} {:>10} {:>12} {:>14} {:>14} {:>12}",
+            "size", "blobs", "inline", "roundtrips", "bytes", "time, us", "avg, us") << std::endl;
+        for (const auto& bucket : m_buckets) {
+            if (bucket.count == 0) {
+                continue;
+            }
+            const auto total = duration_cast<microseconds>(bucket.elapsed).count();
+            std::cout << std::format("  {:<10} {:>10} {:>10} {:>12} {:>14} {:>14} {:>12.1f}",
+                bucket.name, bucket.count, bucket.inline_count, bucket.roundtrips, bucket.bytes,
+                total, static_cast<double>(total) / static_cast<double>(bucket.count)) << std::endl;
+        }
+    }
+
+    // per-size breakdown of BLOB reads, set only with --size-buckets
+    bool sizeBucketStat = false;
+
+    /// <summary>
+    /// Second, untimed pass over the statement that puts each BLOB into its size bucket.
+    /// A span of a BLOB reads the wire counters before and after it, so it must stay out of the timed pass.
+    /// </summary>
+    /// <param name="out">Output message the rows are fetched into</param>
+    /// <param name="blobId">Returns the BLOB ID of the fetched row, or nullptr if the row has no BLOB to read</param>
+    template <typename Message, typename GetBlobId>
+    BlobSizeBuckets collectSizeBuckets(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Firebird::ITransaction* tra,
+        Firebird::IStatement* stmt, Firebird::IMessageMetadata* outMetadata, Message& out, GetBlobId&& blobId)
+    {
+        BlobSizeBuckets buckets;
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, nullptr, nullptr, outMetadata, 0);
+        while (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            ISC_QUAD* id = blobId();
+            if (!id) {
+                continue;
+            }
+            WireSpans::Span span(status, att, "blob", WireSpans::Mode::ALWAYS);
+            Firebird::AutoRelease<Firebird::IBlob> blob = att->openBlob(status, tra, id, 0, nullptr);
+            const auto s = readBlob(status, blob);
+            blob->close(status);
+            blob.release();
+            buckets.add(span.end(), s.size());
+        }
+        rs->close(status);
+        rs.release();
+        return buckets;
+    }
+
+    void printTestHeader(const std::string& title)
+    {
+        std::cout << std::endl << "** " << title << " **" << std::endl;
+        std::cout << "------------------------------------------------------------------------------------" << std::endl;
+        currentScenario = title;
+        if (wireTracer) {
+            wireTracer->beginScenario(title);
+        }
+    }
+
+    /// <summary>
+    /// Warming up the cache
     /// </summary>
     /// <param name="status">Status</param>
     /// <param name="att">Database attachment</param>
-    /// <param name="readBlobKind">What types of blobs to read: all, short, long</param>
-    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
-    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
-    void testWithReadBlob(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Read_Blob_Kind readBlobKind, 
-        std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {})
+    void cacheWarmingUp(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att)
     {
         using std::chrono::duration_cast;
         using std::chrono::high_resolution_clock;
@@ -450,6 +905,60 @@ FROM BLOB_TEST
 
         Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, std::size(tpb), tpb);
 
+        std::cout << "SQL:" << std::endl << SQL_CACHE_WARMING << std::endl;
+
+        Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, SQL_CACHE_WARMING, 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+
+        Firebird::AutoRelease<Firebird::IMessageMetadata> inMetadata = stmt->getInputMetadata(status);
+        Firebird::AutoRelease<Firebird::IMessageMetadata> outMetadata = stmt->getOutputMetadata(status);
+
+        auto t0 = high_resolution_clock::now();
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, inMetadata, nullptr, outMetadata, 0);
+
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, MAX_CHAR_LENGTH)
+        ) out(status, master);
+
+        int64_t s = 0;
+        if (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            s = out->MAX_CHAR_LENGTH;
+        }
+        auto t1 = high_resolution_clock::now();
+        auto elapsed = duration_cast<milliseconds>(t1 - t0);
+        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
+        std::cout << "Max char length: " << s << std::endl;
+
+        rs->close(status);
+        rs.release();
+
+        stmt->free(status);
+        stmt.release();
+
+        tra->commit(status);
+        tra.release();
+    }
+
+    /// <summary>
+    /// Test reading only identifiers BLOB.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="readBlobKind">What types of blobs to read: all, short, long</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
+    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
+    /// <param name="tpb">Transaction parameters buffer</param>
+    /// <returns>Elapsed time, number of records and wire statistics</returns>
+    TestResult testReadBlobId(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Read_Blob_Kind readBlobKind, 
+        std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {},
+        std::span<const unsigned char> tpb = DEFAULT_READ_TPB)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::high_resolution_clock;
+        using std::chrono::milliseconds;
+
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, static_cast<unsigned>(tpb.size()), tpb.data());
+
         std::string sql = sql_for_blob_read_kind(readBlobKind);
         if (limit_rows.has_value()) {
             sql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
@@ -470,6 +979,7 @@ FROM BLOB_TEST
 
         WireStartCollector wireStatCollector;
 
+        wireStatCollector.beginMonStat(status);
         auto t0 = high_resolution_clock::now();
 
         wireStatCollector.startStatCollect(status, att);
@@ -482,30 +992,23 @@ FROM BLOB_TEST
         ) out(status, master);
 
         int64_t max_id = 0;
-        size_t blb_size = 0;
         int64_t record_count = 0;
-        while (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
+        while (tracedFetchNext(status, att, rs, out.getData()) == Firebird::IStatus::RESULT_OK) {
             max_id = std::max<int64_t>(max_id, out->id);
             ++record_count;
-
-            Firebird::AutoRelease<Firebird::IBlob> blob = att->openBlob(status, tra, &out->content, 0, nullptr);
-            auto s = readBlob(status, blob);
-            blob->close(status);
-            blob.release();
-
-            blb_size += s.size();
         }
-
-        wireStatCollector.endStatCollect(status, att);
+        wireStatCollector.endStatCollect();
 
         auto t1 = high_resolution_clock::now();
+        wireStatCollector.endMonStat(status);
         auto elapsed = duration_cast<milliseconds>(t1 - t0);
         std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
         std::cout << "Max id: " << max_id << std::endl;
         std::cout << "Record count: " << record_count << std::endl;
-        std::cout << "Content size: " << blb_size << " bytes" << std::endl;
         wireStatCollector.printWireStat();
 
+        const TestResult result{ duration_cast<std::chrono::microseconds>(t1 - t0), record_count, wireStatCollector.getWireStatDelta() };
+
         rs->close(status);
         rs.release();
 
@@ -514,25 +1017,31 @@ FROM BLOB_TEST
 
         tra->commit(status);
         tra.release();
+
+        return result;
     }
 
     /// <summary>
-    /// Test reading VARCHARs.
+    /// Test reading BLOBs.
     /// </summary>
     /// <param name="status">Status</param>
     /// <param name="att">Database attachment</param>
+    /// <param name="readBlobKind">What types of blobs to read: all, short, long</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
     /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
-    void testReadVarchar(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, std::optional<uint64_t> limit_rows = {})
+    /// <param name="tpb">Transaction parameters buffer</param>
+    /// <returns>Elapsed time, number of records and wire statistics</returns>
+    TestResult testWithReadBlob(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Read_Blob_Kind readBlobKind, 
+        std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {},
+        std::span<const unsigned char> tpb = DEFAULT_READ_TPB)
     {
         using std::chrono::duration_cast;
         using std::chrono::high_resolution_clock;
         using std::chrono::milliseconds;
 
-        unsigned char tpb[] = { isc_tpb_version1, isc_tpb_read, isc_tpb_read_committed, isc_tpb_read_consistency };
-
-        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, std::size(tpb), tpb);
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, static_cast<unsigned>(tpb.size()), tpb.data());
 
-        std::string sql = SQL_VARCHAR_READ;
+        std::string sql = sql_for_blob_read_kind(readBlobKind);
         if (limit_rows.has_value()) {
             sql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
         }
@@ -540,11 +1049,19 @@ FROM BLOB_TEST
 
         Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, sql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
 
+        if (stmt->cloopVTable->version >= stmt->VERSION) {
+            if (max_inline_blob_size.has_value()) {
+                stmt->setMaxInlineBlobSize(status, max_inline_blob_size.value());
+            }
+            std::cout << std::format("MaxInlineBlobSize = {}", stmt->getMaxInlineBlobSize(status)) << std::endl;
+        }
+
         Firebird::AutoRelease<Firebird::IMessageMetadata> inMetadata = stmt->getInputMetadata(status);
         Firebird::AutoRelease<Firebird::IMessageMetadata> outMetadata = stmt->getOutputMetadata(status);
 
         WireStartCollector wireStatCollector;
 
+        wireStatCollector.beginMonStat(status);
         auto t0 = high_resolution_clock::now();
 
         wireStatCollector.startStatCollect(status, att);
@@ -553,21 +1070,30 @@ FROM BLOB_TEST
 
         FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
             (FB_BIGINT, id)
-            (FB_VARCHAR(8191 * 4), short_content)
+            (FB_BLOB, content)
         ) out(status, master);
 
         int64_t max_id = 0;
         size_t blb_size = 0;
         int64_t record_count = 0;
-        while (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
+        int64_t blob_count = 0;
+        while (tracedFetchNext(status, att, rs, out.getData()) == Firebird::IStatus::RESULT_OK) {
             max_id = std::max<int64_t>(max_id, out->id);
             ++record_count;
 
-            blb_size += out->short_content.length;
+            Firebird::AutoRelease<Firebird::IBlob> blob = tracedOpenBlob(status, att, tra, &out->content);
+            ++blob_count;
+            auto s = tracedReadBlob(status, att, blob);
+            tracedCloseBlob(status, att, blob);
+            blob.release();
+
+            blb_size += s.size();
         }
-        wireStatCollector.endStatCollect(status, att);
+
+        wireStatCollector.endStatCollect();
 
         auto t1 = high_resolution_clock::now();
+        wireStatCollector.endMonStat(status);
         auto elapsed = duration_cast<milliseconds>(t1 - t0);
         std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
         std::cout << "Max id: " << max_id << std::endl;
@@ -575,41 +1101,83 @@ FROM BLOB_TEST
         std::cout << "Content size: " << blb_size << " bytes" << std::endl;
         wireStatCollector.printWireStat();
 
+        const TestResult result{ duration_cast<std::chrono::microseconds>(t1 - t0), record_count, wireStatCollector.getWireStatDelta(), blob_count };
+
         rs->close(status);
         rs.release();
 
+        if (sizeBucketStat) {
+            collectSizeBuckets(status, att, tra, stmt, outMetadata, out, [&out]() -> ISC_QUAD* {
+                return out->contentNull ? nullptr : &out->content;
+            }).print();
+        }
+
         stmt->free(status);
         stmt.release();
 
         tra->commit(status);
         tra.release();
+
+        return result;
     }
 
     /// <summary>
-    /// Test reading mixing BLOBs and VARCHARs.
+    /// Query returning (ID, BLOB) rows. The {} placeholder is replaced by the row source,
+    /// BLOB_TEST or a derived table with the row limit.
+    /// </summary>
+    struct ServerBlobQuery {
+        const char* name;
+        const char* sql;
+    };
+
+    const std::vector<ServerBlobQuery>& serverBlobQueries()
+    {
+        // the first query reads the stored column, the others return temporary BLOBs created by the server
+        static const std::vector<ServerBlobQuery> queries = {
+            { "stored CONTENT", "SELECT ID, CONTENT FROM {}" },
+            { "CAST(CONTENT AS BLOB ... OCTETS)", "SELECT ID, CAST(CONTENT AS BLOB SUB_TYPE TEXT CHARACTER SET OCTETS) FROM {}" },
+            { "CONTENT || ''", "SELECT ID, CONTENT || '' FROM {}" },
+            { "BLOB_APPEND(CONTENT, '')", "SELECT ID, BLOB_APPEND(CONTENT, '') FROM {}" },
+            { "SUBSTRING(CONTENT FROM 1 FOR 4096)", "SELECT ID, SUBSTRING(CONTENT FROM 1 FOR 4096) FROM {}" },
+            { "REPLACE(CONTENT, ...)", "SELECT ID, REPLACE(CONTENT, 'Firebird', 'FIREBIRD') FROM {}" },
+            { "LIST(CONTENT) of 10 rows", "SELECT MIN(ID), LIST(CONTENT, '') FROM {} GROUP BY ID / 10" }
+        };
+        return queries;
+    }
+
+    struct ServerBlobStat {
+        // BLOBs read without a roundtrip, i.e. sent inline with the row
+        int64_t inline_count = 0;
+        // roundtrips of BLOB open, read and close
+        int64_t blob_roundtrips = 0;
+    };
+
+    /// <summary>
+    /// Test reading BLOBs returned by a query. The timed pass reads the BLOBs without extra calls;
+    /// a second, untimed pass takes wire counters around each BLOB to count BLOBs sent inline.
     /// </summary>
     /// <param name="status">Status</param>
     /// <param name="att">Database attachment</param>
-    /// <param name="optimize">Flag for selecting SQL query</param>
+    /// <param name="query">Query returning (ID, BLOB) rows</param>
+    /// <param name="blobStat">Receives the inline and BLOB roundtrip counts</param>
     /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
-    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
-    void testMixedRead(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, bool optimize, 
-        std::optional<unsigned short> max_inline_blob_size = {}, 
-        std::optional<uint64_t> limit_rows = {})
+    /// <param name="limit_rows">Limit on the number of source rows</param>
+    /// <returns>Elapsed time, number of records and wire statistics</returns>
+    TestResult testServerBlobRead(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, const ServerBlobQuery& query,
+        ServerBlobStat& blobStat, std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {})
     {
         using std::chrono::duration_cast;
         using std::chrono::high_resolution_clock;
         using std::chrono::milliseconds;
 
-        unsigned char tpb[] = { isc_tpb_version1, isc_tpb_read, isc_tpb_read_committed, isc_tpb_read_consistency };
-
-        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, std::size(tpb), tpb);
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, std::size(DEFAULT_READ_TPB), DEFAULT_READ_TPB);
 
-        std::string sql = optimize ? SQL_MIXED_OPT_READ : SQL_MIXED_READ;
+        std::string source = "BLOB_TEST";
         if (limit_rows.has_value()) {
-            sql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
+            source = std::format("(SELECT ID, CONTENT FROM BLOB_TEST FETCH FIRST {} ROWS ONLY) T", limit_rows.value());
         }
-        std::cout << "SQL:" << std::endl << sql << std::endl;
+        const std::string sql = std::vformat(query.sql, std::make_format_args(source));
+        std::cout << "SQL:" << std::endl << sql << std::endl << std::endl;
 
         Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, sql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
 
@@ -620,61 +1188,3257 @@ FROM BLOB_TEST
             std::cout << std::format("MaxInlineBlobSize = {}", stmt->getMaxInlineBlobSize(status)) << std::endl;
         }
 
-        Firebird::AutoRelease<Firebird::IMessageMetadata> inMetadata = stmt->getInputMetadata(status);
-        Firebird::AutoRelease<Firebird::IMessageMetadata> outMetadata = stmt->getOutputMetadata(status);
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+            (FB_BLOB, content)
+        ) out(status, master);
 
         WireStartCollector wireStatCollector;
 
+        wireStatCollector.beginMonStat(status);
         auto t0 = high_resolution_clock::now();
 
         wireStatCollector.startStatCollect(status, att);
 
-        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, inMetadata, nullptr, outMetadata, 0);
-
-        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
-            (FB_BIGINT, id)
-            (FB_VARCHAR(8191 * 4), short_content)
-            (FB_BLOB, content)
-        ) out(status, master);
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, nullptr, nullptr, out.getMetadata(), 0);
 
-        int64_t max_id = 0;
         size_t blb_size = 0;
         int64_t record_count = 0;
-        while (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
-            max_id = std::max<int64_t>(max_id, out->id);
+        int64_t blob_count = 0;
+        while (tracedFetchNext(status, att, rs, out.getData()) == Firebird::IStatus::RESULT_OK) {
             ++record_count;
+            if (out->contentNull) {
+                continue;
+            }
 
-            if (out->short_contentNull && !out->contentNull) {
-                // Read from blob
-                Firebird::AutoRelease<Firebird::IBlob> blob = att->openBlob(status, tra, &out->content, 0, nullptr);
-                auto s = readBlob(status, blob);
-                blob->close(status);
-                blob.release();
+            Firebird::AutoRelease<Firebird::IBlob> blob = tracedOpenBlob(status, att, tra, &out->content);
+            ++blob_count;
+            auto s = tracedReadBlob(status, att, blob);
+            tracedCloseBlob(status, att, blob);
+            blob.release();
 
-                blb_size += s.size();
-            }
-            else {
-                blb_size += out->short_content.length;
-            }
+            blb_size += s.size();
         }
-        wireStatCollector.endStatCollect(status, att);
+
+        wireStatCollector.endStatCollect();
 
         auto t1 = high_resolution_clock::now();
-        auto elapsed = duration_cast<milliseconds>(t1 - t0);
-        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
-        std::cout << "Max id: " << max_id << std::endl;
-        std::cout << "Record count: " << record_count << std::endl;
-        std::cout << "Content size: " << blb_size << " bytes" << std::endl;
-        wireStatCollector.printWireStat();
+        wireStatCollector.endMonStat(status);
 
         rs->close(status);
         rs.release();
 
-        stmt->free(status);
-        stmt.release();
+        // second, untimed pass: wire counters around each BLOB tell which BLOBs came inline
+        rs = stmt->openCursor(status, tra, nullptr, nullptr, out.getMetadata(), 0);
+        while (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            if (out->contentNull) {
+                continue;
+            }
+            FbWireStat before{};
+            const bool valid = getWireStat(status, att, before);
 
-        tra->commit(status);
-        tra.release();
+            Firebird::AutoRelease<Firebird::IBlob> blob = att->openBlob(status, tra, &out->content, 0, nullptr);
+            readBlob(status, blob);
+            blob->close(status);
+            blob.release();
+
+            FbWireStat after{};
+            if (valid && getWireStat(status, att, after)) {
+                const int64_t roundtrips = after.wire_roundtrips - before.wire_roundtrips;
+                blobStat.blob_roundtrips += roundtrips;
+                if (roundtrips == 0) {
+                    ++blobStat.inline_count;
+                }
+            }
+        }
+        rs->close(status);
+        rs.release();
+
+        auto elapsed = duration_cast<milliseconds>(t1 - t0);
+        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
+        std::cout << "Record count: " << record_count << std::endl;
+        std::cout << "Content size: " << blb_size << " bytes" << std::endl;
+        std::cout << "Inline BLOBs: " << blobStat.inline_count << std::endl;
+        std::cout << "BLOB roundtrips: " << blobStat.blob_roundtrips << std::endl;
+        wireStatCollector.printWireStat();
+
+        const TestResult result{ duration_cast<std::chrono::microseconds>(t1 - t0), record_count, wireStatCollector.getWireStatDelta(), blob_count };
+
+        stmt->free(status);
+        stmt.release();
+
+        tra->commit(status);
+        tra.release();
+
+        return result;
+    }
+
+    /// <summary>
+    /// Test reading BLOBs in groups. BLOB IDs of the next batch_size fetched rows are collected first,
+    /// then all BLOBs of the group are opened, read and closed back to back, so the client can
+    /// send deferred open/close packets together with the next request instead of waiting for each of them.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="batch_size">Number of rows whose BLOBs are processed together</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
+    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
+    /// <param name="tpb">Transaction parameters buffer</param>
+    /// <returns>Elapsed time, number of records and wire statistics</returns>
+    TestResult testDeferredBlobRead(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, size_t batch_size,
+        std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {},
+        std::span<const unsigned char> tpb = DEFAULT_READ_TPB)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::high_resolution_clock;
+        using std::chrono::milliseconds;
+
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, static_cast<unsigned>(tpb.size()), tpb.data());
+
+        std::string sql = SQL_ALL_BLOB_READ;
+        if (limit_rows.has_value()) {
+            sql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
+        }
+        std::cout << "SQL:" << std::endl << sql << std::endl;
+        std::cout << "Batch size: " << batch_size << std::endl;
+
+        Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, sql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+
+        if (stmt->cloopVTable->version >= stmt->VERSION) {
+            if (max_inline_blob_size.has_value()) {
+                stmt->setMaxInlineBlobSize(status, max_inline_blob_size.value());
+            }
+            std::cout << std::format("MaxInlineBlobSize = {}", stmt->getMaxInlineBlobSize(status)) << std::endl;
+        }
+
+        Firebird::AutoRelease<Firebird::IMessageMetadata> inMetadata = stmt->getInputMetadata(status);
+        Firebird::AutoRelease<Firebird::IMessageMetadata> outMetadata = stmt->getOutputMetadata(status);
+
+        WireStartCollector wireStatCollector;
+
+        wireStatCollector.beginMonStat(status);
+        auto t0 = high_resolution_clock::now();
+
+        wireStatCollector.startStatCollect(status, att);
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, inMetadata, nullptr, outMetadata, 0);
+
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+            (FB_BLOB, content)
+        ) out(status, master);
+
+        std::vector<ISC_QUAD> blobIds;
+        blobIds.reserve(batch_size);
+        std::vector<Firebird::AutoRelease<Firebird::IBlob>> blobs;
+        blobs.reserve(batch_size);
+
+        int64_t max_id = 0;
+        size_t blb_size = 0;
+        int64_t record_count = 0;
+        int64_t blob_count = 0;
+        int64_t batch_count = 0;
+        bool eof = false;
+        while (!eof) {
+            blobIds.clear();
+            while (blobIds.size() < batch_size) {
+                if (tracedFetchNext(status, att, rs, out.getData()) != Firebird::IStatus::RESULT_OK) {
+                    eof = true;
+                    break;
+                }
+                max_id = std::max<int64_t>(max_id, out->id);
+                ++record_count;
+                if (!out->contentNull) {
+                    blobIds.push_back(out->content);
+                }
+            }
+            if (blobIds.empty()) {
+                continue;
+            }
+            ++batch_count;
+
+            for (auto& blobId : blobIds) {
+                ++blob_count;
+                blobs.emplace_back(tracedOpenBlob(status, att, tra, &blobId));
+            }
+            for (auto& blob : blobs) {
+                blb_size += tracedReadBlob(status, att, blob).size();
+            }
+            for (auto& blob : blobs) {
+                tracedCloseBlob(status, att, blob);
+                blob.release();
+            }
+            blobs.clear();
+        }
+
+        wireStatCollector.endStatCollect();
+
+        auto t1 = high_resolution_clock::now();
+        wireStatCollector.endMonStat(status);
+        auto elapsed = duration_cast<milliseconds>(t1 - t0);
+        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
+        std::cout << "Max id: " << max_id << std::endl;
+        std::cout << "Record count: " << record_count << std::endl;
+        std::cout << "Batch count: " << batch_count << std::endl;
+        std::cout << "Content size: " << blb_size << " bytes" << std::endl;
+        wireStatCollector.printWireStat();
+
+        const TestResult result{ duration_cast<std::chrono::microseconds>(t1 - t0), record_count, wireStatCollector.getWireStatDelta(), blob_count };
+
+        rs->close(status);
+        rs.release();
+
+        stmt->free(status);
+        stmt.release();
+
+        tra->commit(status);
+        tra.release();
+
+        return result;
+    }
+
+    /// <summary>
+    /// Test reading VARCHARs.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
+    /// <param name="tpb">Transaction parameters buffer</param>
+    /// <returns>Elapsed time, number of records and wire statistics</returns>
+    TestResult testReadVarchar(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, std::optional<uint64_t> limit_rows = {},
+        std::span<const unsigned char> tpb = DEFAULT_READ_TPB)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::high_resolution_clock;
+        using std::chrono::milliseconds;
+
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, static_cast<unsigned>(tpb.size()), tpb.data());
+
+        std::string sql = SQL_VARCHAR_READ;
+        if (limit_rows.has_value()) {
+            sql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
+        }
+        std::cout << "SQL:" << std::endl << sql << std::endl;
+
+        Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, sql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+
+        Firebird::AutoRelease<Firebird::IMessageMetadata> inMetadata = stmt->getInputMetadata(status);
+        Firebird::AutoRelease<Firebird::IMessageMetadata> outMetadata = stmt->getOutputMetadata(status);
+
+        WireStartCollector wireStatCollector;
+
+        wireStatCollector.beginMonStat(status);
+        auto t0 = high_resolution_clock::now();
+
+        wireStatCollector.startStatCollect(status, att);
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, inMetadata, nullptr, outMetadata, 0);
+
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+            (FB_VARCHAR(8191 * 4), short_content)
+        ) out(status, master);
+
+        int64_t max_id = 0;
+        size_t blb_size = 0;
+        int64_t record_count = 0;
+        while (tracedFetchNext(status, att, rs, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            max_id = std::max<int64_t>(max_id, out->id);
+            ++record_count;
+
+            blb_size += out->short_content.length;
+        }
+        wireStatCollector.endStatCollect();
+
+        auto t1 = high_resolution_clock::now();
+        wireStatCollector.endMonStat(status);
+        auto elapsed = duration_cast<milliseconds>(t1 - t0);
+        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
+        std::cout << "Max id: " << max_id << std::endl;
+        std::cout << "Record count: " << record_count << std::endl;
+        std::cout << "Content size: " << blb_size << " bytes" << std::endl;
+        wireStatCollector.printWireStat();
+
+        const TestResult result{ duration_cast<std::chrono::microseconds>(t1 - t0), record_count, wireStatCollector.getWireStatDelta() };
+
+        rs->close(status);
+        rs.release();
+
+        stmt->free(status);
+        stmt.release();
+
+        tra->commit(status);
+        tra.release();
+
+        return result;
+    }
+
+    /// <summary>
+    /// Test reading mixing BLOBs and VARCHARs.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="optimize">Flag for selecting SQL query</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
+    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
+    /// <param name="tpb">Transaction parameters buffer</param>
+    /// <returns>Elapsed time, number of records and wire statistics</returns>
+    TestResult testMixedRead(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, bool optimize, 
+        std::optional<unsigned short> max_inline_blob_size = {}, 
+        std::optional<uint64_t> limit_rows = {},
+        std::span<const unsigned char> tpb = DEFAULT_READ_TPB)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::high_resolution_clock;
+        using std::chrono::milliseconds;
+
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, static_cast<unsigned>(tpb.size()), tpb.data());
+
+        std::string sql = optimize ? SQL_MIXED_OPT_READ : SQL_MIXED_READ;
+        if (limit_rows.has_value()) {
+            sql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
+        }
+        std::cout << "SQL:" << std::endl << sql << std::endl;
+
+        Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, sql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+
+        if (stmt->cloopVTable->version >= stmt->VERSION) {
+            if (max_inline_blob_size.has_value()) {
+                stmt->setMaxInlineBlobSize(status, max_inline_blob_size.value());
+            }
+            std::cout << std::format("MaxInlineBlobSize = {}", stmt->getMaxInlineBlobSize(status)) << std::endl;
+        }
+
+        Firebird::AutoRelease<Firebird::IMessageMetadata> inMetadata = stmt->getInputMetadata(status);
+        Firebird::AutoRelease<Firebird::IMessageMetadata> outMetadata = stmt->getOutputMetadata(status);
+
+        WireStartCollector wireStatCollector;
+
+        wireStatCollector.beginMonStat(status);
+        auto t0 = high_resolution_clock::now();
+
+        wireStatCollector.startStatCollect(status, att);
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, inMetadata, nullptr, outMetadata, 0);
+
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+            (FB_VARCHAR(8191 * 4), short_content)
+            (FB_BLOB, content)
+        ) out(status, master);
+
+        int64_t max_id = 0;
+        size_t blb_size = 0;
+        int64_t record_count = 0;
+        int64_t blob_count = 0;
+        while (tracedFetchNext(status, att, rs, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            max_id = std::max<int64_t>(max_id, out->id);
+            ++record_count;
+
+            if (out->short_contentNull && !out->contentNull) {
+                // Read from blob
+                Firebird::AutoRelease<Firebird::IBlob> blob = tracedOpenBlob(status, att, tra, &out->content);
+                ++blob_count;
+                auto s = tracedReadBlob(status, att, blob);
+                tracedCloseBlob(status, att, blob);
+                blob.release();
+
+                blb_size += s.size();
+            }
+            else {
+                blb_size += out->short_content.length;
+            }
+        }
+        wireStatCollector.endStatCollect();
+
+        auto t1 = high_resolution_clock::now();
+        wireStatCollector.endMonStat(status);
+        auto elapsed = duration_cast<milliseconds>(t1 - t0);
+        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
+        std::cout << "Max id: " << max_id << std::endl;
+        std::cout << "Record count: " << record_count << std::endl;
+        std::cout << "Content size: " << blb_size << " bytes" << std::endl;
+        wireStatCollector.printWireStat();
+
+        const TestResult result{ duration_cast<std::chrono::microseconds>(t1 - t0), record_count, wireStatCollector.getWireStatDelta(), blob_count };
+
+        rs->close(status);
+        rs.release();
+
+        if (sizeBucketStat) {
+            collectSizeBuckets(status, att, tra, stmt, outMetadata, out, [&out]() -> ISC_QUAD* {
+                return out->short_contentNull && !out->contentNull ? &out->content : nullptr;
+            }).print();
+        }
+
+        stmt->free(status);
+        stmt.release();
+
+        tra->commit(status);
+        tra.release();
+
+        return result;
+    }
+
+    /// <summary>
+    /// Builds the list of parameter markers for an IN predicate: (?, ?, ...)
+    /// </summary>
+    std::string inListSql(const char* prefix, size_t count)
+    {
+        std::string sql = prefix;
+        sql += "(";
+        for (size_t i = 0; i < count; ++i) {
+            sql += (i == 0) ? "?" : ", ?";
+        }
+        sql += ")\n";
+        return sql;
+    }
+
+    /// <summary>
+    /// Fills BIGINT input parameters with identifiers.
+    /// An incomplete batch is padded with its last identifier, duplicates in IN do not add rows.
+    /// </summary>
+    void setBatchIds(Firebird::ThrowStatusWrapper* status, Firebird::IMessageMetadata* meta, unsigned char* buffer,
+        std::span<const int64_t> ids)
+    {
+        const unsigned count = meta->getCount(status);
+        for (unsigned i = 0; i < count; ++i) {
+            const int64_t id = ids[std::min<size_t>(i, ids.size() - 1)];
+            const short null = 0;
+            std::memcpy(buffer + meta->getOffset(status, i), &id, sizeof(id));
+            std::memcpy(buffer + meta->getNullOffset(status, i), &null, sizeof(null));
+        }
+    }
+
+    /// <summary>
+    /// Test reading with a client-driven two-phase strategy.
+    /// First only ID and OCTET_LENGTH(CONTENT) are fetched, then short values are read as VARCHAR
+    /// with batched ID IN (...) queries and only long values are opened as BLOBs.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
+    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
+    /// <param name="batch_size">Number of identifiers in one IN list</param>
+    /// <param name="tpb">Transaction parameters buffer</param>
+    /// <returns>Elapsed time, number of records and wire statistics</returns>
+    TestResult testTwoPhaseRead(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att,
+        std::optional<unsigned short> max_inline_blob_size = {},
+        std::optional<uint64_t> limit_rows = {},
+        size_t batch_size = 128,
+        std::span<const unsigned char> tpb = DEFAULT_READ_TPB)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::high_resolution_clock;
+        using std::chrono::milliseconds;
+
+        // the lengths are in bytes and short values are fetched as OCTETS,
+        // so the message slot is exactly the threshold whatever the connection character set
+        constexpr int64_t SHORT_LENGTH_LIMIT = 8191;
+
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, static_cast<unsigned>(tpb.size()), tpb.data());
+
+        std::string lengthSql = SQL_LENGTH_READ;
+        if (limit_rows.has_value()) {
+            lengthSql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
+        }
+        const std::string varcharSql = inListSql(SQL_BATCH_VARCHAR_READ, batch_size);
+        const std::string blobSql = inListSql(SQL_BATCH_BLOB_READ, batch_size);
+        std::cout << "SQL:" << std::endl << lengthSql << std::endl;
+        std::cout << "SQL:" << std::endl << SQL_BATCH_VARCHAR_READ << std::format("(?, ... {} parameters)", batch_size) << std::endl;
+        std::cout << "SQL:" << std::endl << SQL_BATCH_BLOB_READ << std::format("(?, ... {} parameters)", batch_size) << std::endl;
+
+        Firebird::AutoRelease<Firebird::IStatement> lengthStmt = att->prepare(status, tra, 0, lengthSql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+        Firebird::AutoRelease<Firebird::IStatement> varcharStmt = att->prepare(status, tra, 0, varcharSql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+        Firebird::AutoRelease<Firebird::IStatement> blobStmt = att->prepare(status, tra, 0, blobSql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+
+        if (blobStmt->cloopVTable->version >= blobStmt->VERSION) {
+            if (max_inline_blob_size.has_value()) {
+                blobStmt->setMaxInlineBlobSize(status, max_inline_blob_size.value());
+            }
+            std::cout << std::format("MaxInlineBlobSize = {}", blobStmt->getMaxInlineBlobSize(status)) << std::endl;
+        }
+
+        Firebird::AutoRelease<Firebird::IMessageMetadata> varcharInMetadata = varcharStmt->getInputMetadata(status);
+        Firebird::AutoRelease<Firebird::IMessageMetadata> blobInMetadata = blobStmt->getInputMetadata(status);
+        std::vector<unsigned char> varcharInBuffer(varcharInMetadata->getMessageLength(status));
+        std::vector<unsigned char> blobInBuffer(blobInMetadata->getMessageLength(status));
+
+        FB_MESSAGE(LengthMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+            (FB_BIGINT, content_length)
+        ) lengthOut(status, master);
+
+        FB_MESSAGE(VarcharMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+            (FB_VARCHAR(SHORT_LENGTH_LIMIT), short_content)
+        ) varcharOut(status, master);
+
+        FB_MESSAGE(BlobMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+            (FB_BLOB, content)
+        ) blobOut(status, master);
+
+        WireStartCollector wireStatCollector;
+
+        wireStatCollector.beginMonStat(status);
+        auto t0 = high_resolution_clock::now();
+
+        wireStatCollector.startStatCollect(status, att);
+
+        // phase 1: lengths, every fetched row is counted as in the other scan tests
+        std::vector<int64_t> shortIds;
+        std::vector<int64_t> longIds;
+        int64_t max_id = 0;
+        int64_t record_count = 0;
+        int64_t null_count = 0;
+        {
+            Firebird::AutoRelease<Firebird::IResultSet> rs = lengthStmt->openCursor(status, tra, nullptr, nullptr, lengthOut.getMetadata(), 0);
+            while (tracedFetchNext(status, att, rs, lengthOut.getData()) == Firebird::IStatus::RESULT_OK) {
+                max_id = std::max<int64_t>(max_id, lengthOut->id);
+                ++record_count;
+                if (lengthOut->content_lengthNull) {
+                    ++null_count;
+                    continue;
+                }
+                if (lengthOut->content_length <= SHORT_LENGTH_LIMIT) {
+                    shortIds.push_back(lengthOut->id);
+                }
+                else {
+                    longIds.push_back(lengthOut->id);
+                }
+            }
+            rs->close(status);
+            rs.release();
+        }
+
+        auto t1 = high_resolution_clock::now();
+
+        size_t blb_size = 0;
+        int64_t blob_count = 0;
+        int64_t batch_count = 0;
+
+        // phase 2: short values as VARCHAR
+        for (size_t pos = 0; pos < shortIds.size(); pos += batch_size) {
+            const std::span<const int64_t> batch(shortIds.data() + pos, std::min(batch_size, shortIds.size() - pos));
+            setBatchIds(status, varcharInMetadata, varcharInBuffer.data(), batch);
+            ++batch_count;
+
+            Firebird::AutoRelease<Firebird::IResultSet> rs = varcharStmt->openCursor(status, tra, varcharInMetadata, varcharInBuffer.data(), varcharOut.getMetadata(), 0);
+            while (tracedFetchNext(status, att, rs, varcharOut.getData()) == Firebird::IStatus::RESULT_OK) {
+                blb_size += varcharOut->short_content.length;
+            }
+            rs->close(status);
+            rs.release();
+        }
+
+        auto t2 = high_resolution_clock::now();
+
+        // phase 3: long values as BLOB
+        for (size_t pos = 0; pos < longIds.size(); pos += batch_size) {
+            const std::span<const int64_t> batch(longIds.data() + pos, std::min(batch_size, longIds.size() - pos));
+            setBatchIds(status, blobInMetadata, blobInBuffer.data(), batch);
+            ++batch_count;
+
+            Firebird::AutoRelease<Firebird::IResultSet> rs = blobStmt->openCursor(status, tra, blobInMetadata, blobInBuffer.data(), blobOut.getMetadata(), 0);
+            while (tracedFetchNext(status, att, rs, blobOut.getData()) == Firebird::IStatus::RESULT_OK) {
+                Firebird::AutoRelease<Firebird::IBlob> blob = tracedOpenBlob(status, att, tra, &blobOut->content);
+                ++blob_count;
+                auto s = tracedReadBlob(status, att, blob);
+                tracedCloseBlob(status, att, blob);
+                blob.release();
+
+                blb_size += s.size();
+            }
+            rs->close(status);
+            rs.release();
+        }
+
+        wireStatCollector.endStatCollect();
+
+        auto t3 = high_resolution_clock::now();
+        wireStatCollector.endMonStat(status);
+        auto elapsed = duration_cast<milliseconds>(t3 - t0);
+        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
+        std::cout << std::format("  lengths: {}", duration_cast<milliseconds>(t1 - t0)) << std::endl;
+        std::cout << std::format("  short values: {}", duration_cast<milliseconds>(t2 - t1)) << std::endl;
+        std::cout << std::format("  long values: {}", duration_cast<milliseconds>(t3 - t2)) << std::endl;
+        std::cout << "Max id: " << max_id << std::endl;
+        std::cout << "Record count: " << record_count << std::endl;
+        std::cout << "Short values: " << shortIds.size() << std::endl;
+        std::cout << "Long values: " << longIds.size() << std::endl;
+        std::cout << "NULL values: " << null_count << std::endl;
+        std::cout << "Batch count: " << batch_count << std::endl;
+        std::cout << "Content size: " << blb_size << " bytes" << std::endl;
+        wireStatCollector.printWireStat();
+
+        const TestResult result{ duration_cast<std::chrono::microseconds>(t3 - t0), record_count, wireStatCollector.getWireStatDelta(), blob_count };
+
+        blobStmt->free(status);
+        blobStmt.release();
+
+        varcharStmt->free(status);
+        varcharStmt.release();
+
+        lengthStmt->free(status);
+        lengthStmt.release();
+
+        tra->commit(status);
+        tra.release();
+
+        return result;
+    }
+
+    /// <summary>
+    /// Reusable buffer for one value with the grow()/shrink() interface of ColumnarResult.
+    /// It is zero-filled only when it grows beyond the largest value seen so far.
+    /// </summary>
+    class ValueBuffer final
+    {
+        std::vector<char> m_data;
+        size_t m_size = 0;
+    public:
+        char* grow(size_t length)
+        {
+            if (m_size + length > m_data.size()) {
+                m_data.resize(std::max(m_size + length, m_data.size() * 2));
+            }
+            char* p = m_data.data() + m_size;
+            m_size += length;
+            return p;
+        }
+
+        void shrink(size_t unused)
+        {
+            m_size -= unused;
+        }
+
+        void clear()
+        {
+            m_size = 0;
+        }
+
+        std::string_view view() const
+        {
+            return std::string_view(m_data.data(), m_size);
+        }
+    };
+
+    /// <summary>
+    /// Reads BLOB segments directly into the buffer: the current row of ColumnarResult or a ValueBuffer.
+    /// </summary>
+    /// <returns>Number of bytes read</returns>
+    template <typename Buffer>
+    size_t readBlobInto(Firebird::ThrowStatusWrapper* status, Firebird::IBlob* blob, Buffer& result)
+    {
+        size_t size = 0;
+        bool eof = false;
+        while (!eof) {
+            unsigned int l = 0;
+            char* buffer = result.grow(MAX_SEGMENT_SIZE);
+            const int rc = blob->getSegment(status, MAX_SEGMENT_SIZE, buffer, &l);
+            result.shrink(MAX_SEGMENT_SIZE - l);
+            switch (rc)
+            {
+            case Firebird::IStatus::RESULT_OK:
+            case Firebird::IStatus::RESULT_SEGMENT:
+                size += l;
+                break;
+            default:
+                eof = true;
+                break;
+            }
+        }
+        return size;
+    }
+
+    enum class Result_Layout { ROW_STRINGS, COLUMNAR };
+
+    struct RowValue {
+        int64_t id;
+        std::string content;
+    };
+
+    struct ScanStat {
+        uint64_t total_length;
+        int64_t matches;
+        uint64_t checksum;
+    };
+
+    constexpr std::string_view SCAN_PATTERN = "Firebird";
+    constexpr int SCAN_PASSES = 10;
+
+    /// <summary>
+    /// Downstream processing of a fetched result: total length, rows containing SCAN_PATTERN
+    /// and a checksum that touches every byte.
+    /// </summary>
+    template <typename GetContent>
+    ScanStat scanContent(size_t rows, GetContent&& content)
+    {
+        ScanStat stat{ 0, 0, 0 };
+        for (size_t i = 0; i < rows; i++) {
+            const std::string_view value = content(i);
+            stat.total_length += value.size();
+            if (value.find(SCAN_PATTERN) != std::string_view::npos) {
+                ++stat.matches;
+            }
+            for (const char c : value) {
+                stat.checksum = stat.checksum * 31 + static_cast<unsigned char>(c);
+            }
+        }
+        return stat;
+    }
+
+    /// <summary>
+    /// Test filling a result set from the optimized mixed query, with one std::string per row
+    /// or a columnar container, followed by a scan of the filled result.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="layout">How fetched values are stored on the client</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
+    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
+    /// <param name="tpb">Transaction parameters buffer</param>
+    /// <returns>Elapsed fill time, number of records and wire statistics</returns>
+    TestResult testResultLayout(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Result_Layout layout,
+        std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {},
+        std::span<const unsigned char> tpb = DEFAULT_READ_TPB)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::high_resolution_clock;
+        using std::chrono::milliseconds;
+
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, static_cast<unsigned>(tpb.size()), tpb.data());
+
+        std::string sql = SQL_MIXED_OPT_READ;
+        if (limit_rows.has_value()) {
+            sql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
+        }
+        std::cout << "SQL:" << std::endl << sql << std::endl;
+
+        Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, sql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+
+        if (stmt->cloopVTable->version >= stmt->VERSION) {
+            if (max_inline_blob_size.has_value()) {
+                stmt->setMaxInlineBlobSize(status, max_inline_blob_size.value());
+            }
+            std::cout << std::format("MaxInlineBlobSize = {}", stmt->getMaxInlineBlobSize(status)) << std::endl;
+        }
+
+        Firebird::AutoRelease<Firebird::IMessageMetadata> inMetadata = stmt->getInputMetadata(status);
+        Firebird::AutoRelease<Firebird::IMessageMetadata> outMetadata = stmt->getOutputMetadata(status);
+
+        std::vector<RowValue> rows;
+        ColumnarResult columns;
+
+        WireStartCollector wireStatCollector;
+
+        wireStatCollector.beginMonStat(status);
+        auto t0 = high_resolution_clock::now();
+
+        wireStatCollector.startStatCollect(status, att);
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, inMetadata, nullptr, outMetadata, 0);
+
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+            (FB_VARCHAR(8191 * 4), short_content)
+            (FB_BLOB, content)
+        ) out(status, master);
+
+        ValueBuffer blobBuffer;
+        int64_t blob_count = 0;
+        while (tracedFetchNext(status, att, rs, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            const bool isBlob = out->short_contentNull && !out->contentNull;
+            Firebird::AutoRelease<Firebird::IBlob> blob;
+            if (isBlob) {
+                blob = tracedOpenBlob(status, att, tra, &out->content);
+                ++blob_count;
+            }
+            if (layout == Result_Layout::ROW_STRINGS) {
+                auto& row = rows.emplace_back(RowValue{ out->id, {} });
+                if (isBlob) {
+                    // the same segment loop as the columnar layout, then one exact allocation for the row
+                    blobBuffer.clear();
+                    traceCall(status, att, TraceEvent::BLOB_READ, [&] { return readBlobInto(status, blob, blobBuffer); });
+                    row.content.assign(blobBuffer.view());
+                }
+                else if (!out->short_contentNull) {
+                    row.content.assign(out->short_content.str, out->short_content.length);
+                }
+            }
+            else {
+                if (isBlob) {
+                    columns.beginRow(out->id);
+                    traceCall(status, att, TraceEvent::BLOB_READ, [&] { return readBlobInto(status, blob, columns); });
+                    columns.endRow();
+                }
+                else {
+                    columns.append(out->id, out->short_content.str, out->short_contentNull ? 0 : out->short_content.length);
+                }
+            }
+            if (isBlob) {
+                tracedCloseBlob(status, att, blob);
+                blob.release();
+            }
+        }
+
+        wireStatCollector.endStatCollect();
+
+        auto t1 = high_resolution_clock::now();
+        wireStatCollector.endMonStat(status);
+
+        ScanStat scan{ 0, 0, 0 };
+        size_t record_count = 0;
+        size_t memory_usage = 0;
+        for (int pass = 0; pass < SCAN_PASSES; pass++) {
+            if (layout == Result_Layout::ROW_STRINGS) {
+                scan = scanContent(rows.size(), [&rows](size_t i) { return std::string_view(rows[i].content); });
+            }
+            else {
+                scan = scanContent(columns.size(), [&columns](size_t i) { return columns.content(i); });
+            }
+        }
+
+        auto t2 = high_resolution_clock::now();
+
+        if (layout == Result_Layout::ROW_STRINGS) {
+            record_count = rows.size();
+            memory_usage = rows.capacity() * sizeof(RowValue);
+            for (const auto& row : rows) {
+                // short strings live inside the std::string object
+                if (row.content.capacity() > std::string().capacity()) {
+                    memory_usage += row.content.capacity() + 1;
+                }
+            }
+        }
+        else {
+            record_count = columns.size();
+            memory_usage = columns.memoryUsage();
+        }
+
+        const auto scanTime = duration_cast<std::chrono::microseconds>(t2 - t1) / SCAN_PASSES;
+        std::cout << std::format("Elapsed time: {}", duration_cast<milliseconds>(t1 - t0)) << std::endl;
+        std::cout << "Record count: " << record_count << std::endl;
+        std::cout << "Content size: " << scan.total_length << " bytes" << std::endl;
+        std::cout << "Result memory: " << memory_usage << " bytes" << std::endl;
+        std::cout << std::format("Scan time: {} per pass, {:.1f} MB/s", scanTime,
+            static_cast<double>(scan.total_length) / static_cast<double>(std::max<int64_t>(scanTime.count(), 1)) * 1'000'000.0 / MEGABYTE) << std::endl;
+        std::cout << std::format("Rows containing \"{}\": {}, checksum: {:016x}", SCAN_PATTERN, scan.matches, scan.checksum) << std::endl;
+        wireStatCollector.printWireStat();
+
+        const TestResult result{ duration_cast<std::chrono::microseconds>(t1 - t0), static_cast<int64_t>(record_count), wireStatCollector.getWireStatDelta(), blob_count };
+
+        rs->close(status);
+        rs.release();
+
+        stmt->free(status);
+        stmt.release();
+
+        tra->commit(status);
+        tra.release();
+
+        return result;
+    }
+
+    /// <summary>
+    /// Reads the optimized mixed query like testMixedRead and saves every fetched row
+    /// and BLOB segment with its completion time for a later replay without the server.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="fileName">Recording file</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
+    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
+    /// <param name="tpb">Transaction parameters buffer</param>
+    void recordMixedRead(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, const std::string& fileName,
+        std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {},
+        std::span<const unsigned char> tpb = DEFAULT_READ_TPB)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        using std::chrono::nanoseconds;
+        using std::chrono::steady_clock;
+
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, static_cast<unsigned>(tpb.size()), tpb.data());
+
+        std::string sql = SQL_MIXED_OPT_READ;
+        if (limit_rows.has_value()) {
+            sql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
+        }
+        std::cout << "SQL:" << std::endl << sql << std::endl;
+
+        Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, sql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+
+        if (stmt->cloopVTable->version >= stmt->VERSION) {
+            if (max_inline_blob_size.has_value()) {
+                stmt->setMaxInlineBlobSize(status, max_inline_blob_size.value());
+            }
+            std::cout << std::format("MaxInlineBlobSize = {}", stmt->getMaxInlineBlobSize(status)) << std::endl;
+        }
+
+        Firebird::AutoRelease<Firebird::IMessageMetadata> inMetadata = stmt->getInputMetadata(status);
+        Firebird::AutoRelease<Firebird::IMessageMetadata> outMetadata = stmt->getOutputMetadata(status);
+
+        FetchRecording::Recorder recorder(fileName);
+        std::vector<char> vBuffer(MAX_SEGMENT_SIZE);
+        auto buffer = vBuffer.data();
+
+        auto t0 = steady_clock::now();
+        auto now_ns = [t0]() { return duration_cast<nanoseconds>(steady_clock::now() - t0).count(); };
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, inMetadata, nullptr, outMetadata, 0);
+
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+            (FB_VARCHAR(8191 * 4), short_content)
+            (FB_BLOB, content)
+        ) out(status, master);
+
+        int64_t record_count = 0;
+        while (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            ++record_count;
+
+            if (out->short_contentNull && !out->contentNull) {
+                recorder.addBlobRow(out->id, now_ns());
+                Firebird::AutoRelease<Firebird::IBlob> blob = att->openBlob(status, tra, &out->content, 0, nullptr);
+                bool eof = false;
+                while (!eof) {
+                    unsigned int l = 0;
+                    switch (blob->getSegment(status, MAX_SEGMENT_SIZE, buffer, &l))
+                    {
+                    case Firebird::IStatus::RESULT_OK:
+                    case Firebird::IStatus::RESULT_SEGMENT:
+                        recorder.addSegment(buffer, l, now_ns());
+                        break;
+                    default:
+                        eof = true;
+                        break;
+                    }
+                }
+                blob->close(status);
+                blob.release();
+                recorder.addBlobEnd(now_ns());
+            }
+            else if (out->short_contentNull) {
+                recorder.addNullRow(out->id, now_ns());
+            }
+            else {
+                recorder.addRow(out->id, out->short_content.str, out->short_content.length, now_ns());
+            }
+        }
+
+        auto t1 = steady_clock::now();
+        recorder.finish();
+
+        std::cout << std::format("Elapsed time: {}", duration_cast<milliseconds>(t1 - t0)) << std::endl;
+        std::cout << "Record count: " << record_count << std::endl;
+        std::cout << "Events: " << recorder.eventCount() << std::endl;
+        std::cout << "Content size: " << recorder.dataSize() << " bytes" << std::endl;
+        std::cout << "Recording saved to " << fileName << std::endl;
+
+        rs->close(status);
+        rs.release();
+
+        stmt->free(status);
+        stmt.release();
+
+        tra->commit(status);
+        tra.release();
+    }
+
+    constexpr int REPLAY_PASSES = 5;
+
+    /// <summary>
+    /// Feeds a recording through the client-side consumers without Firebird:
+    /// std::string per row as readBlob builds it, a checksum of all bytes and a columnar fill.
+    /// Each consumer runs REPLAY_PASSES times and the fastest pass is reported.
+    /// </summary>
+    /// <param name="fileName">Recording file</param>
+    void replayRecording(const std::string& fileName)
+    {
+        using FetchRecording::EventKind;
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        using std::chrono::milliseconds;
+        using std::chrono::nanoseconds;
+        using std::chrono::steady_clock;
+
+        const FetchRecording::MappedRecording recording(fileName);
+        const auto events = recording.events();
+
+        // original timing: the gap before each event is the time of the call that produced it
+        int64_t rows = 0;
+        int64_t blobs = 0;
+        int64_t segments = 0;
+        uint64_t bytes = 0;
+        int64_t row_wait_ns = 0;
+        int64_t blob_wait_ns = 0;
+        int64_t prev_ns = 0;
+        for (const auto& event : events) {
+            const int64_t gap = event.time_ns - prev_ns;
+            prev_ns = event.time_ns;
+            bytes += event.length;
+            switch (event.kind)
+            {
+            case EventKind::ROW_BLOB:
+                ++blobs;
+                [[fallthrough]];
+            case EventKind::ROW_VARCHAR:
+            case EventKind::ROW_NULL:
+                ++rows;
+                row_wait_ns += gap;
+                break;
+            case EventKind::BLOB_SEGMENT:
+                ++segments;
+                [[fallthrough]];
+            default:
+                blob_wait_ns += gap;
+                break;
+            }
+        }
+
+        std::cout << "Recording: " << fileName << ", " << recording.fileSize() << " bytes" << std::endl;
+        std::cout << "Record count: " << rows << std::endl;
+        std::cout << "BLOB count: " << blobs << std::endl;
+        std::cout << "Segment count: " << segments << std::endl;
+        std::cout << "Content size: " << bytes << " bytes" << std::endl;
+        std::cout << std::format("Original elapsed time: {}", duration_cast<milliseconds>(nanoseconds(prev_ns))) << std::endl;
+        std::cout << std::format("  fetch: {}", duration_cast<milliseconds>(nanoseconds(row_wait_ns))) << std::endl;
+        std::cout << std::format("  BLOB open/read/close: {}", duration_cast<milliseconds>(nanoseconds(blob_wait_ns))) << std::endl;
+
+        auto replay = [&](const char* name, auto&& consume) {
+            auto best = steady_clock::duration::max();
+            uint64_t check = 0;
+            for (int pass = 0; pass < REPLAY_PASSES; pass++) {
+                const auto t0 = steady_clock::now();
+                check = consume();
+                best = std::min(best, steady_clock::now() - t0);
+            }
+            const auto us = duration_cast<microseconds>(best).count();
+            std::cout << std::format("  {:<20} {:>12} us {:>10.1f} MB/s  check {:016x}", name, us,
+                static_cast<double>(bytes) / static_cast<double>(std::max<int64_t>(us, 1)) * 1'000'000.0 / MEGABYTE, check) << std::endl;
+        };
+
+        std::cout << std::format("Replay, best of {} passes:", REPLAY_PASSES) << std::endl;
+
+        replay("readBlob strings", [&]() -> uint64_t {
+            std::vector<RowValue> values;
+            for (const auto& event : events) {
+                switch (event.kind)
+                {
+                case EventKind::ROW_VARCHAR:
+                    values.push_back({ event.id, std::string(recording.data(event), event.length) });
+                    break;
+                case EventKind::ROW_NULL:
+                case EventKind::ROW_BLOB:
+                    values.push_back({ event.id, {} });
+                    break;
+                case EventKind::BLOB_SEGMENT:
+                    values.back().content.append(recording.data(event), event.length);
+                    break;
+                default:
+                    break;
+                }
+            }
+            return values.size();
+        });
+
+        replay("checksum", [&]() -> uint64_t {
+            uint64_t checksum = 0;
+            for (const auto& event : events) {
+                const char* p = recording.data(event);
+                for (uint64_t i = 0; i < event.length; i++) {
+                    checksum = checksum * 31 + static_cast<unsigned char>(p[i]);
+                }
+            }
+            return checksum;
+        });
+
+        replay("columnar fill", [&]() -> uint64_t {
+            ColumnarResult columns;
+            for (const auto& event : events) {
+                switch (event.kind)
+                {
+                case EventKind::ROW_VARCHAR:
+                    columns.append(event.id, recording.data(event), event.length);
+                    break;
+                case EventKind::ROW_NULL:
+                    columns.append(event.id, "", 0);
+                    break;
+                case EventKind::ROW_BLOB:
+                    columns.beginRow(event.id);
+                    break;
+                case EventKind::BLOB_SEGMENT:
+                    std::memcpy(columns.grow(event.length), recording.data(event), event.length);
+                    break;
+                case EventKind::BLOB_END:
+                    columns.endRow();
+                    break;
+                default:
+                    break;
+                }
+            }
+            return columns.size();
+        });
+    }
+
+    /// <summary>
+    /// Test reading documents stored as ordered VARCHAR(8191) chunk rows.
+    /// The chunks are fetched with a single cursor and reassembled on the client into a reused buffer.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="limit_rows">Limit on the number of documents returned by a query</param>
+    /// <param name="tpb">Transaction parameters buffer</param>
+    /// <returns>Elapsed time, number of records and wire statistics</returns>
+    TestResult testReadChunked(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, std::optional<uint64_t> limit_rows = {},
+        std::span<const unsigned char> tpb = DEFAULT_READ_TPB)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::high_resolution_clock;
+        using std::chrono::milliseconds;
+
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, static_cast<unsigned>(tpb.size()), tpb.data());
+
+        std::string source = "BLOB_TEST_CHUNK C";
+        if (limit_rows.has_value()) {
+            // the limit applies to documents, not to chunks; a derived table is evaluated once, unlike an IN subquery
+            source = std::format("(SELECT ID FROM BLOB_TEST FETCH FIRST {} ROWS ONLY) D\n  JOIN BLOB_TEST_CHUNK C ON C.ID = D.ID", limit_rows.value());
+        }
+        const std::string sql = std::vformat(SQL_CHUNKED_READ, std::make_format_args(source));
+        std::cout << "SQL:" << std::endl << sql << std::endl;
+
+        Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, sql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+
+        Firebird::AutoRelease<Firebird::IMessageMetadata> inMetadata = stmt->getInputMetadata(status);
+        Firebird::AutoRelease<Firebird::IMessageMetadata> outMetadata = stmt->getOutputMetadata(status);
+
+        WireStartCollector wireStatCollector;
+
+        wireStatCollector.beginMonStat(status);
+        auto t0 = high_resolution_clock::now();
+
+        wireStatCollector.startStatCollect(status, att);
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, inMetadata, nullptr, outMetadata, 0);
+
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+            (FB_VARCHAR(8191 * 4), chunk)
+        ) out(status, master);
+
+        int64_t max_id = 0;
+        size_t blb_size = 0;
+        int64_t record_count = 0;
+        int64_t chunk_count = 0;
+        std::optional<int64_t> current_id;
+        // the buffer keeps its capacity between documents
+        std::string content;
+        while (tracedFetchNext(status, att, rs, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            ++chunk_count;
+            if (current_id != out->id) {
+                if (current_id.has_value()) {
+                    blb_size += content.size();
+                }
+                content.clear();
+                current_id = out->id;
+                max_id = std::max<int64_t>(max_id, out->id);
+                ++record_count;
+            }
+            content.append(out->chunk.str, out->chunk.length);
+        }
+        if (current_id.has_value()) {
+            blb_size += content.size();
+        }
+        wireStatCollector.endStatCollect();
+
+        auto t1 = high_resolution_clock::now();
+        wireStatCollector.endMonStat(status);
+        auto elapsed = duration_cast<milliseconds>(t1 - t0);
+        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
+        std::cout << "Max id: " << max_id << std::endl;
+        std::cout << "Record count: " << record_count << std::endl;
+        std::cout << "Chunk count: " << chunk_count << std::endl;
+        std::cout << "Content size: " << blb_size << " bytes" << std::endl;
+        wireStatCollector.printWireStat();
+
+        const TestResult result{ duration_cast<std::chrono::microseconds>(t1 - t0), record_count, wireStatCollector.getWireStatDelta() };
+
+        rs->close(status);
+        rs.release();
+
+        stmt->free(status);
+        stmt.release();
+
+        tra->commit(status);
+        tra.release();
+
+        return result;
+    }
+
+    constexpr const char* SQL_PACKED_STAT = R"(
+SELECT
+  COUNT(*),
+  SUM(RAW_LENGTH),
+  SUM(OCTET_LENGTH(CONTENT))
+FROM BLOB_TEST_PACKED
+)";
+
+    constexpr const char* SQL_PLAIN_STAT = R"(
+SELECT
+  COUNT(*),
+  SUM(OCTET_LENGTH(CONTENT))
+FROM BLOB_TEST
+)";
+
+    constexpr const char* SQL_INSERT_PACKED = R"(
+INSERT INTO BLOB_TEST_PACKED (ID, RAW_LENGTH, CONTENT)
+VALUES (?, ?, ?)
+)";
+
+    constexpr const char* SQL_PACKED_READ = R"(
+SELECT
+  ID,
+  RAW_LENGTH,
+  CONTENT
+FROM BLOB_TEST_PACKED
+)";
+
+    struct PackedStorage {
+        int64_t plain_bytes = 0;
+        int64_t packed_rows = 0;
+        int64_t packed_raw_bytes = 0;
+        int64_t packed_bytes = 0;
+    };
+
+    PackedStorage getPackedStorage(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Firebird::ITransaction* tra)
+    {
+        PackedStorage storage;
+        {
+            FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+                (FB_BIGINT, cnt)
+                (FB_BIGINT, raw_length)
+                (FB_BIGINT, packed_length)
+            ) out(status, master);
+
+            att->execute(status, tra, 0, SQL_PACKED_STAT, 3, nullptr, nullptr, out.getMetadata(), out.getData());
+            storage.packed_rows = out->cnt;
+            storage.packed_raw_bytes = out->raw_lengthNull ? 0 : out->raw_length;
+            storage.packed_bytes = out->packed_lengthNull ? 0 : out->packed_length;
+        }
+        {
+            FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+                (FB_BIGINT, cnt)
+                (FB_BIGINT, plain_length)
+            ) out(status, master);
+
+            att->execute(status, tra, 0, SQL_PLAIN_STAT, 3, nullptr, nullptr, out.getMetadata(), out.getData());
+            storage.plain_bytes = out->plain_lengthNull ? 0 : out->plain_length;
+        }
+        return storage;
+    }
+
+    /// <summary>
+    /// Fills BLOB_TEST_PACKED with LZ4-compressed copies of BLOB_TEST contents if it is empty,
+    /// and prints the stored sizes of both tables.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    void preparePackedTable(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        using std::chrono::steady_clock;
+
+        unsigned char tpb[] = { isc_tpb_version1, isc_tpb_write, isc_tpb_read_committed, isc_tpb_rec_version, isc_tpb_wait };
+
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, std::size(tpb), tpb);
+
+        auto storage = getPackedStorage(status, att, tra);
+        if (storage.packed_rows == 0) {
+            std::cout << "SQL:" << std::endl << SQL_ALL_BLOB_READ << std::endl;
+            std::cout << "SQL:" << std::endl << SQL_INSERT_PACKED << std::endl;
+
+            Firebird::AutoRelease<Firebird::IStatement> selectStmt = att->prepare(status, tra, 0, SQL_ALL_BLOB_READ, 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+            Firebird::AutoRelease<Firebird::IStatement> insertStmt = att->prepare(status, tra, 0, SQL_INSERT_PACKED, 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+
+            FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+                (FB_BIGINT, id)
+                (FB_BLOB, content)
+            ) out(status, master);
+
+            FB_MESSAGE(InsertMessage, Firebird::ThrowStatusWrapper,
+                (FB_BIGINT, id)
+                (FB_INTEGER, raw_length)
+                (FB_BLOB, content)
+            ) ins(status, master);
+
+            // the compressed value is stored as a stream BLOB of binary subtype
+            const unsigned char bpb[] = { isc_bpb_version1, isc_bpb_type, 1, isc_bpb_type_stream };
+
+            std::chrono::nanoseconds compressTime{ 0 };
+            int64_t rows = 0;
+            const auto t0 = steady_clock::now();
+
+            Firebird::AutoRelease<Firebird::IResultSet> rs = selectStmt->openCursor(status, tra, nullptr, nullptr, out.getMetadata(), 0);
+            while (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
+                if (out->contentNull) {
+                    continue;
+                }
+                Firebird::AutoRelease<Firebird::IBlob> blob = att->openBlob(status, tra, &out->content, 0, nullptr);
+                const auto s = readBlob(status, blob);
+                blob->close(status);
+                blob.release();
+
+                const auto c0 = steady_clock::now();
+                const auto packed = Lz4Block::compress(s);
+                compressTime += steady_clock::now() - c0;
+
+                ins->idNull = false;
+                ins->id = out->id;
+                ins->raw_lengthNull = false;
+                ins->raw_length = static_cast<ISC_LONG>(s.size());
+                ins->contentNull = false;
+
+                Firebird::AutoRelease<Firebird::IBlob> newBlob = att->createBlob(status, tra, &ins->content, sizeof(bpb), bpb);
+                for (size_t pos = 0; pos < packed.size(); pos += MAX_SEGMENT_SIZE) {
+                    const auto length = static_cast<unsigned int>(std::min<size_t>(MAX_SEGMENT_SIZE, packed.size() - pos));
+                    newBlob->putSegment(status, length, packed.data() + pos);
+                }
+                newBlob->close(status);
+                newBlob.release();
+
+                insertStmt->execute(status, tra, ins.getMetadata(), ins.getData(), nullptr, nullptr);
+                ++rows;
+            }
+            rs->close(status);
+            rs.release();
+
+            selectStmt->free(status);
+            selectStmt.release();
+
+            insertStmt->free(status);
+            insertStmt.release();
+
+            tra->commitRetaining(status);
+
+            storage = getPackedStorage(status, att, tra);
+            const auto elapsed = duration_cast<milliseconds>(steady_clock::now() - t0);
+            std::cout << std::format("Packed rows: {}, elapsed time: {}", rows, elapsed) << std::endl;
+            std::cout << std::format("Compression time: {} ms, {:.1f} MB/s",
+                duration_cast<milliseconds>(compressTime).count(),
+                storage.packed_raw_bytes / std::max(std::chrono::duration<double>(compressTime).count(), 1e-9) / MEGABYTE) << std::endl;
+        }
+
+        std::cout << "Plain content: " << storage.plain_bytes << " bytes" << std::endl;
+        std::cout << "Packed content: " << storage.packed_bytes << " bytes, uncompressed " << storage.packed_raw_bytes << " bytes" << std::endl;
+        std::cout << std::format("Compression ratio: {:.2f}",
+            static_cast<double>(storage.packed_raw_bytes) / static_cast<double>(std::max<int64_t>(storage.packed_bytes, 1))) << std::endl;
+
+        tra->commit(status);
+        tra.release();
+    }
+
+    /// <summary>
+    /// Test reading LZ4-compressed contents from BLOB_TEST_PACKED and decompressing them on the client
+    /// into a reused buffer.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
+    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
+    /// <param name="tpb">Transaction parameters buffer</param>
+    /// <returns>Elapsed time, number of records and wire statistics</returns>
+    TestResult testReadPacked(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att,
+        std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {},
+        std::span<const unsigned char> tpb = DEFAULT_READ_TPB)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::high_resolution_clock;
+        using std::chrono::milliseconds;
+
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, static_cast<unsigned>(tpb.size()), tpb.data());
+
+        std::string sql = SQL_PACKED_READ;
+        if (limit_rows.has_value()) {
+            sql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
+        }
+        std::cout << "SQL:" << std::endl << sql << std::endl;
+
+        Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, sql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+
+        if (stmt->cloopVTable->version >= stmt->VERSION) {
+            if (max_inline_blob_size.has_value()) {
+                stmt->setMaxInlineBlobSize(status, max_inline_blob_size.value());
+            }
+            std::cout << std::format("MaxInlineBlobSize = {}", stmt->getMaxInlineBlobSize(status)) << std::endl;
+        }
+
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+            (FB_INTEGER, raw_length)
+            (FB_BLOB, content)
+        ) out(status, master);
+
+        WireStartCollector wireStatCollector;
+
+        wireStatCollector.beginMonStat(status);
+        auto t0 = high_resolution_clock::now();
+
+        wireStatCollector.startStatCollect(status, att);
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, nullptr, nullptr, out.getMetadata(), 0);
+
+        int64_t max_id = 0;
+        size_t packed_size = 0;
+        size_t blb_size = 0;
+        int64_t record_count = 0;
+        int64_t blob_count = 0;
+        std::chrono::nanoseconds decompressTime{ 0 };
+        // the buffer keeps its capacity between rows
+        std::string content;
+        while (tracedFetchNext(status, att, rs, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            max_id = std::max<int64_t>(max_id, out->id);
+            ++record_count;
+            if (out->contentNull) {
+                continue;
+            }
+
+            Firebird::AutoRelease<Firebird::IBlob> blob = tracedOpenBlob(status, att, tra, &out->content);
+            ++blob_count;
+            const auto packed = tracedReadBlob(status, att, blob);
+            tracedCloseBlob(status, att, blob);
+            blob.release();
+
+            const auto d0 = high_resolution_clock::now();
+            content.resize(static_cast<size_t>(out->raw_length));
+            if (!Lz4Block::decompress(packed.data(), packed.size(), content.data(), content.size())) {
+                throw std::runtime_error(std::format("Corrupted packed content of record {}", out->id));
+            }
+            decompressTime += high_resolution_clock::now() - d0;
+
+            packed_size += packed.size();
+            blb_size += content.size();
+        }
+
+        wireStatCollector.endStatCollect();
+
+        auto t1 = high_resolution_clock::now();
+        wireStatCollector.endMonStat(status);
+        auto elapsed = duration_cast<milliseconds>(t1 - t0);
+        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
+        std::cout << "Max id: " << max_id << std::endl;
+        std::cout << "Record count: " << record_count << std::endl;
+        std::cout << "Packed size: " << packed_size << " bytes" << std::endl;
+        std::cout << "Content size: " << blb_size << " bytes" << std::endl;
+        std::cout << std::format("Decompression time: {} ms, {:.1f} MB/s", duration_cast<milliseconds>(decompressTime).count(),
+            blb_size / std::max(std::chrono::duration<double>(decompressTime).count(), 1e-9) / MEGABYTE) << std::endl;
+        wireStatCollector.printWireStat();
+
+        const TestResult result{ duration_cast<std::chrono::microseconds>(t1 - t0), record_count, wireStatCollector.getWireStatDelta(), blob_count };
+
+        rs->close(status);
+        rs.release();
+
+        stmt->free(status);
+        stmt.release();
+
+        tra->commit(status);
+        tra.release();
+
+        return result;
+    }
+
+    using AttachFactory = std::function<Firebird::IAttachment*(Firebird::ThrowStatusWrapper*)>;
+
+    constexpr const char* SQL_LOAD_IDS = R"(
+SELECT
+  ID
+FROM BLOB_TEST
+)";
+
+    constexpr const char* SQL_POINT_LOOKUP = R"(
+SELECT
+  CONTENT
+FROM BLOB_TEST
+WHERE ID = ?
+)";
+
+    constexpr const char* SQL_SHORT_POINT_LOOKUP = R"(
+SELECT
+  CONTENT
+FROM BLOB_TEST
+WHERE ID = ? AND SHORT_BLOB IS TRUE
+)";
+
+    constexpr const char* SQL_LONG_POINT_LOOKUP = R"(
+SELECT
+  CONTENT
+FROM BLOB_TEST
+WHERE ID = ? AND SHORT_BLOB IS FALSE
+)";
+
+    /// <summary>
+    /// Loads identifiers of BLOB_TEST records used as keys by the lookup tests.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
+    /// <returns>Record identifiers</returns>
+    std::vector<int64_t> loadIds(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, std::optional<uint64_t> limit_rows = {})
+    {
+        unsigned char tpb[] = { isc_tpb_version1, isc_tpb_read, isc_tpb_read_committed, isc_tpb_read_consistency };
+
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, std::size(tpb), tpb);
+
+        std::string sql = SQL_LOAD_IDS;
+        if (limit_rows.has_value()) {
+            sql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
+        }
+
+        Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, sql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+        ) out(status, master);
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, nullptr, nullptr, out.getMetadata(), 0);
+
+        std::vector<int64_t> ids;
+        while (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            ids.push_back(out->id);
+        }
+
+        rs->close(status);
+        rs.release();
+
+        stmt->free(status);
+        stmt.release();
+
+        tra->commit(status);
+        tra.release();
+
+        return ids;
+    }
+
+    struct LatencySummary {
+        size_t count = 0;
+        double mean = 0.0;
+        int64_t p50 = 0;
+        int64_t p90 = 0;
+        int64_t p99 = 0;
+        int64_t p999 = 0;
+        int64_t max = 0;
+    };
+
+    /// <summary>
+    /// Calculates nearest-rank percentiles. The values are sorted in place.
+    /// </summary>
+    LatencySummary summarizeLatency(std::vector<int64_t>& values)
+    {
+        LatencySummary summary;
+        if (values.empty()) {
+            return summary;
+        }
+        std::sort(values.begin(), values.end());
+        auto rank = [&values](double p) {
+            const auto n = static_cast<size_t>(std::ceil(p * static_cast<double>(values.size())));
+            return values[std::clamp<size_t>(n, 1, values.size()) - 1];
+        };
+        summary.count = values.size();
+        summary.mean = static_cast<double>(std::accumulate(values.begin(), values.end(), int64_t{ 0 })) / static_cast<double>(values.size());
+        summary.p50 = rank(0.50);
+        summary.p90 = rank(0.90);
+        summary.p99 = rank(0.99);
+        summary.p999 = rank(0.999);
+        summary.max = values.back();
+        return summary;
+    }
+
+    /// <summary>
+    /// Reads the BLOB of one record found by the prepared point lookup statement.
+    /// </summary>
+    /// <returns>Content size, or -1 if the record is not found</returns>
+    int64_t lookupBlob(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Firebird::ITransaction* tra,
+        Firebird::IStatement* stmt, int64_t id)
+    {
+        FB_MESSAGE(InMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+        ) in(status, master);
+
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BLOB, content)
+        ) out(status, master);
+
+        in->idNull = false;
+        in->id = id;
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, in.getMetadata(), in.getData(), out.getMetadata(), 0);
+
+        int64_t blb_size = -1;
+        if (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            blb_size = 0;
+            if (!out->contentNull) {
+                Firebird::AutoRelease<Firebird::IBlob> blob = att->openBlob(status, tra, &out->content, 0, nullptr);
+                auto s = readBlob(status, blob);
+                blob->close(status);
+                blob.release();
+
+                blb_size = static_cast<int64_t>(s.size());
+            }
+        }
+
+        rs->close(status);
+        rs.release();
+
+        return blb_size;
+    }
+
+    /// <summary>
+    /// Point lookup through the client BLOB cache. The row is always fetched to get the current
+    /// BLOB ID; the BLOB is opened and read only when its content is not in the cache.
+    /// </summary>
+    /// <returns>Content size, or -1 if the record is not found</returns>
+    int64_t lookupBlobCached(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Firebird::ITransaction* tra,
+        Firebird::IStatement* stmt, int64_t id, BlobCache& cache, int64_t snapshot, bool& hit)
+    {
+        FB_MESSAGE(InMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+        ) in(status, master);
+
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BLOB, content)
+        ) out(status, master);
+
+        in->idNull = false;
+        in->id = id;
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, in.getMetadata(), in.getData(), out.getMetadata(), 0);
+
+        hit = false;
+        int64_t blb_size = -1;
+        if (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            blb_size = 0;
+            if (!out->contentNull) {
+                const BlobCache::Key key{ id,
+                    (static_cast<uint64_t>(static_cast<uint32_t>(out->content.gds_quad_high)) << 32) | out->content.gds_quad_low,
+                    snapshot };
+                if (const auto* content = cache.find(key)) {
+                    hit = true;
+                    blb_size = static_cast<int64_t>(content->size());
+                }
+                else {
+                    Firebird::AutoRelease<Firebird::IBlob> blob = att->openBlob(status, tra, &out->content, 0, nullptr);
+                    auto s = readBlob(status, blob);
+                    blob->close(status);
+                    blob.release();
+
+                    blb_size = static_cast<int64_t>(s.size());
+                    cache.insert(key, std::move(s));
+                }
+            }
+        }
+
+        rs->close(status);
+        rs.release();
+
+        return blb_size;
+    }
+
+    struct LoadSample {
+        int64_t intended_us;  // intended start, relative to the start of the test
+        int64_t latency_us;   // from the intended start to completion
+        int64_t service_us;   // from the actual start to completion
+    };
+
+    /// <summary>
+    /// Open-loop load test. BLOB lookups by random ID are scheduled at a fixed rate
+    /// and executed by a pool of attachments. Latency is measured from the intended
+    /// start of each request, so a stalled server is not hidden by coordinated omission.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment used to load the keys</param>
+    /// <param name="connect">Creates worker attachments</param>
+    /// <param name="rate">Target rate, requests per second</param>
+    /// <param name="duration">Test duration</param>
+    /// <param name="connections">Number of worker attachments</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
+    /// <param name="limit_rows">Limit on the number of keys</param>
+    void testOpenLoopLoad(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, const AttachFactory& connect,
+        double rate, std::chrono::seconds duration, unsigned connections,
+        std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {})
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        using std::chrono::steady_clock;
+
+        const auto ids = loadIds(status, att, limit_rows);
+        if (ids.empty()) {
+            std::cout << "BLOB_TEST is empty" << std::endl;
+            return;
+        }
+
+        std::cout << "SQL:" << std::endl << SQL_POINT_LOOKUP << std::endl;
+        std::cout << std::format("Target rate: {} req/s, duration: {}, connections: {}, keys: {}",
+            rate, duration, connections, ids.size()) << std::endl;
+
+        const auto interval = std::chrono::duration<double, std::micro>(1'000'000.0 / rate);
+        const auto request_count = static_cast<int64_t>(rate * static_cast<double>(duration.count()));
+
+        std::atomic<int64_t> next_request = 0;
+        std::atomic<int64_t> error_count = 0;
+        std::vector<std::vector<LoadSample>> samples(connections);
+        std::vector<std::string> errors(connections);
+        std::vector<std::thread> workers;
+
+        // all workers attach before the schedule starts
+        std::vector<Firebird::AutoRelease<Firebird::IAttachment>> attachments;
+        attachments.reserve(connections);
+        for (unsigned i = 0; i < connections; i++) {
+            attachments.emplace_back(connect(status));
+        }
+
+        const auto t0 = steady_clock::now() + std::chrono::milliseconds(100);
+
+        for (unsigned w = 0; w < connections; w++) {
+            workers.emplace_back([&, w]() {
+                Firebird::AutoDispose<Firebird::IStatus> st = master->getStatus();
+                Firebird::ThrowStatusWrapper workerStatus(st);
+                auto& workerAtt = attachments[w];
+                std::mt19937_64 rnd(w + 1);
+                std::uniform_int_distribution<size_t> keyDist(0, ids.size() - 1);
+                auto& workerSamples = samples[w];
+                workerSamples.reserve(static_cast<size_t>(request_count / connections + 1));
+                try {
+                    unsigned char tpb[] = { isc_tpb_version1, isc_tpb_read, isc_tpb_read_committed, isc_tpb_read_consistency };
+                    Firebird::AutoRelease<Firebird::ITransaction> tra = workerAtt->startTransaction(&workerStatus, std::size(tpb), tpb);
+                    Firebird::AutoRelease<Firebird::IStatement> stmt = workerAtt->prepare(&workerStatus, tra, 0, SQL_POINT_LOOKUP, 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+                    if (max_inline_blob_size.has_value() && stmt->cloopVTable->version >= stmt->VERSION) {
+                        stmt->setMaxInlineBlobSize(&workerStatus, max_inline_blob_size.value());
+                    }
+
+                    for (int64_t n = next_request++; n < request_count; n = next_request++) {
+                        const auto intended = t0 + duration_cast<steady_clock::duration>(interval * static_cast<double>(n));
+                        std::this_thread::sleep_until(intended);
+                        const auto started = steady_clock::now();
+                        lookupBlob(&workerStatus, workerAtt, tra, stmt, ids[keyDist(rnd)]);
+                        const auto finished = steady_clock::now();
+                        workerSamples.push_back({
+                            duration_cast<microseconds>(intended - t0).count(),
+                            duration_cast<microseconds>(finished - intended).count(),
+                            duration_cast<microseconds>(finished - started).count()
+                        });
+                    }
+
+                    stmt->free(&workerStatus);
+                    stmt.release();
+
+                    tra->commit(&workerStatus);
+                    tra.release();
+
+                    workerAtt->detach(&workerStatus);
+                    workerAtt.release();
+                }
+                catch (const Firebird::FbException& e) {
+                    char message_buffer[2048];
+                    master->getUtilInterface()->formatStatus(message_buffer, static_cast<unsigned int>(std::size(message_buffer)), e.getStatus());
+                    errors[w] = message_buffer;
+                    ++error_count;
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        const auto t1 = steady_clock::now();
+
+        for (const auto& error : errors) {
+            if (!error.empty()) {
+                std::cout << "Worker error: " << error << std::endl;
+            }
+        }
+
+        // latency is grouped by the window of the intended start, throughput by the window of completion
+        constexpr int64_t WINDOW_US = 1'000'000;
+        std::vector<std::vector<int64_t>> windows;
+        std::vector<int64_t> completions;
+        std::vector<int64_t> all_latency;
+        std::vector<int64_t> all_service;
+        for (const auto& workerSamples : samples) {
+            for (const auto& sample : workerSamples) {
+                const auto window = static_cast<size_t>(sample.intended_us / WINDOW_US);
+                const auto completed = static_cast<size_t>((sample.intended_us + sample.latency_us) / WINDOW_US);
+                if (windows.size() <= std::max(window, completed)) {
+                    windows.resize(std::max(window, completed) + 1);
+                    completions.resize(windows.size());
+                }
+                windows[window].push_back(sample.latency_us);
+                ++completions[completed];
+                all_latency.push_back(sample.latency_us);
+                all_service.push_back(sample.service_us);
+            }
+        }
+
+        std::cout << "Completed requests per second and latency from intended start, ms:" << std::endl;
+        std::cout << std::format("  {:>6} {:>10} {:>9} {:>9} {:>9} {:>9}", "window", "req/s", "p50", "p90", "p99", "max") << std::endl;
+        for (size_t i = 0; i < windows.size(); i++) {
+            const auto summary = summarizeLatency(windows[i]);
+            std::cout << std::format("  {:>5}s {:>10} {:>9.2f} {:>9.2f} {:>9.2f} {:>9.2f}", i, completions[i],
+                summary.p50 / 1000.0, summary.p90 / 1000.0, summary.p99 / 1000.0, summary.max / 1000.0) << std::endl;
+        }
+
+        const auto latency = summarizeLatency(all_latency);
+        const auto service = summarizeLatency(all_service);
+        const auto elapsed = duration_cast<std::chrono::milliseconds>(t1 - t0);
+        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
+        std::cout << "Requests scheduled: " << request_count << std::endl;
+        std::cout << "Requests completed: " << latency.count << std::endl;
+        std::cout << "Failed workers: " << error_count << std::endl;
+        std::cout << std::format("Throughput: {:.1f} req/s", latency.count * 1000.0 / std::max<int64_t>(elapsed.count(), 1)) << std::endl;
+        std::cout << std::format("Latency, ms: mean = {:.2f}, p50 = {:.2f}, p90 = {:.2f}, p99 = {:.2f}, p99.9 = {:.2f}, max = {:.2f}",
+            latency.mean / 1000.0, latency.p50 / 1000.0, latency.p90 / 1000.0, latency.p99 / 1000.0, latency.p999 / 1000.0, latency.max / 1000.0) << std::endl;
+        std::cout << std::format("Service time, ms: mean = {:.2f}, p50 = {:.2f}, p99 = {:.2f}, max = {:.2f}",
+            service.mean / 1000.0, service.p50 / 1000.0, service.p99 / 1000.0, service.max / 1000.0) << std::endl;
+    }
+
+    enum class Key_Distribution { UNIFORM, ZIPFIAN, HOTSET };
+
+    const char* key_distribution_name(Key_Distribution distribution)
+    {
+        switch (distribution)
+        {
+        case Key_Distribution::UNIFORM:
+            return "uniform";
+        case Key_Distribution::ZIPFIAN:
+            return "zipfian";
+        case Key_Distribution::HOTSET:
+            return "hotset";
+        default:
+            return "unknown";
+        }
+    }
+
+    /// <summary>
+    /// Picks lookup keys. For the skewed distributions the popularity rank of a key
+    /// is mapped to a shuffled key order, so hot keys are spread over the table
+    /// instead of being the lowest identifiers.
+    /// Zipfian uses exponent 0.99, hotset sends 90% of lookups to 10% of keys.
+    /// </summary>
+    class KeyGenerator final
+    {
+    private:
+        std::vector<int64_t> m_keys;
+        Key_Distribution m_distribution;
+        std::mt19937_64 m_rnd;
+        std::vector<double> m_cdf;
+    public:
+        KeyGenerator(std::vector<int64_t> keys, Key_Distribution distribution, uint64_t seed)
+            : m_keys(std::move(keys))
+            , m_distribution(distribution)
+            , m_rnd(seed)
+        {
+            std::shuffle(m_keys.begin(), m_keys.end(), m_rnd);
+            if (m_distribution == Key_Distribution::ZIPFIAN) {
+                constexpr double THETA = 0.99;
+                m_cdf.resize(m_keys.size());
+                double sum = 0.0;
+                for (size_t i = 0; i < m_keys.size(); i++) {
+                    sum += 1.0 / std::pow(static_cast<double>(i + 1), THETA);
+                    m_cdf[i] = sum;
+                }
+                for (auto& v : m_cdf) {
+                    v /= sum;
+                }
+            }
+        }
+
+        int64_t next()
+        {
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+            switch (m_distribution)
+            {
+            case Key_Distribution::ZIPFIAN: {
+                const auto it = std::lower_bound(m_cdf.begin(), m_cdf.end(), unit(m_rnd));
+                return m_keys[std::min<size_t>(static_cast<size_t>(it - m_cdf.begin()), m_keys.size() - 1)];
+            }
+            case Key_Distribution::HOTSET: {
+                const size_t hot = std::max<size_t>(m_keys.size() / 10, 1);
+                if (unit(m_rnd) < 0.9 || hot == m_keys.size()) {
+                    return m_keys[std::uniform_int_distribution<size_t>(0, hot - 1)(m_rnd)];
+                }
+                return m_keys[std::uniform_int_distribution<size_t>(hot, m_keys.size() - 1)(m_rnd)];
+            }
+            default:
+                return m_keys[std::uniform_int_distribution<size_t>(0, m_keys.size() - 1)(m_rnd)];
+            }
+        }
+    };
+
+    /// <summary>
+    /// Test of BLOB lookups by primary key with a statement prepared once.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="distribution">Key distribution</param>
+    /// <param name="lookups">Number of lookups</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
+    /// <param name="limit_rows">Limit on the number of keys</param>
+    /// <param name="cache_size">Size in bytes of the client BLOB cache, no cache if empty.
+    /// The cache lives for the single transaction of the test, so reuse across transactions is not measured</param>
+    /// <param name="tpb">Transaction parameters buffer</param>
+    /// <returns>Elapsed time, number of lookups and wire statistics</returns>
+    TestResult testPointLookup(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Key_Distribution distribution,
+        int64_t lookups, std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {},
+        std::optional<size_t> cache_size = {}, std::span<const unsigned char> tpb = DEFAULT_READ_TPB)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        using std::chrono::milliseconds;
+        using std::chrono::steady_clock;
+
+        auto ids = loadIds(status, att, limit_rows);
+        if (ids.empty()) {
+            std::cout << "BLOB_TEST is empty" << std::endl;
+            return {};
+        }
+        const size_t key_count = ids.size();
+        // the same key sequence for each run with this distribution
+        KeyGenerator keys(std::move(ids), distribution, 1);
+
+        Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(status, static_cast<unsigned>(tpb.size()), tpb.data());
+
+        std::cout << "SQL:" << std::endl << SQL_POINT_LOOKUP << std::endl;
+        std::cout << std::format("Key distribution: {}, keys: {}, lookups: {}", key_distribution_name(distribution), key_count, lookups) << std::endl;
+
+        Firebird::AutoRelease<Firebird::IStatement> stmt = att->prepare(status, tra, 0, SQL_POINT_LOOKUP, 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+
+        if (stmt->cloopVTable->version >= stmt->VERSION) {
+            if (max_inline_blob_size.has_value()) {
+                stmt->setMaxInlineBlobSize(status, max_inline_blob_size.value());
+            }
+            std::cout << std::format("MaxInlineBlobSize = {}", stmt->getMaxInlineBlobSize(status)) << std::endl;
+        }
+
+        std::optional<BlobCache> cache;
+        int64_t snapshot = 0;
+        if (cache_size.has_value()) {
+            cache.emplace(cache_size.value());
+            snapshot = getSnapshotNumber(status, tra);
+            std::cout << std::format("Client BLOB cache: {} bytes, snapshot number: {}", cache_size.value(), snapshot) << std::endl;
+        }
+
+        std::vector<int64_t> latency;
+        latency.reserve(static_cast<size_t>(lookups));
+        std::vector<int64_t> hitLatency;
+        std::vector<int64_t> missLatency;
+
+        WireStartCollector wireStatCollector;
+
+        wireStatCollector.beginMonStat(status);
+        auto t0 = steady_clock::now();
+
+        wireStatCollector.startStatCollect(status, att);
+
+        size_t blb_size = 0;
+        int64_t not_found = 0;
+        for (int64_t i = 0; i < lookups; i++) {
+            const auto id = keys.next();
+            const auto started = steady_clock::now();
+            bool hit = false;
+            const auto size = cache
+                ? lookupBlobCached(status, att, tra, stmt, id, cache.value(), snapshot, hit)
+                : lookupBlob(status, att, tra, stmt, id);
+            const auto us = duration_cast<microseconds>(steady_clock::now() - started).count();
+            latency.push_back(us);
+            if (cache) {
+                (hit ? hitLatency : missLatency).push_back(us);
+            }
+            if (size < 0) {
+                ++not_found;
+            }
+            else {
+                blb_size += static_cast<size_t>(size);
+            }
+        }
+
+        wireStatCollector.endStatCollect();
+
+        auto t1 = steady_clock::now();
+        wireStatCollector.endMonStat(status);
+        const auto wire = wireStatCollector.getWireStatDelta();
+        const auto summary = summarizeLatency(latency);
+        std::cout << std::format("Elapsed time: {}", duration_cast<milliseconds>(t1 - t0)) << std::endl;
+        std::cout << "Lookups: " << lookups << std::endl;
+        std::cout << "Not found: " << not_found << std::endl;
+        std::cout << "Content size: " << blb_size << " bytes" << std::endl;
+        std::cout << std::format("Latency, us: mean = {:.1f}, p50 = {}, p90 = {}, p99 = {}, p99.9 = {}, max = {}",
+            summary.mean, summary.p50, summary.p90, summary.p99, summary.p999, summary.max) << std::endl;
+        std::cout << std::format("Roundtrips per lookup: {:.2f}",
+            static_cast<double>(wire.wire_roundtrips) / static_cast<double>(std::max<int64_t>(lookups, 1))) << std::endl;
+        if (cache) {
+            const auto& cacheStat = cache->stat();
+            const auto hits = summarizeLatency(hitLatency);
+            const auto misses = summarizeLatency(missLatency);
+            std::cout << std::format("Cache hits: {}, misses: {}, hit rate: {:.1f}%, evictions: {}, rejected: {}",
+                cacheStat.hits, cacheStat.misses,
+                cacheStat.hits * 100.0 / static_cast<double>(std::max<int64_t>(cacheStat.hits + cacheStat.misses, 1)),
+                cacheStat.evictions, cacheStat.rejected) << std::endl;
+            std::cout << std::format("Cache entries: {}, content: {} bytes, memory: {} bytes",
+                cache->entryCount(), cache->size(), cache->memoryUsage()) << std::endl;
+            std::cout << std::format("Hit latency, us: mean = {:.1f}, p50 = {}, p99 = {}, max = {}",
+                hits.mean, hits.p50, hits.p99, hits.max) << std::endl;
+            std::cout << std::format("Miss latency, us: mean = {:.1f}, p50 = {}, p99 = {}, max = {}",
+                misses.mean, misses.p50, misses.p99, misses.max) << std::endl;
+        }
+        wireStatCollector.printWireStat();
+
+        const TestResult result{ duration_cast<microseconds>(t1 - t0), lookups, wire };
+
+        stmt->free(status);
+        stmt.release();
+
+        tra->commit(status);
+        tra.release();
+
+        return result;
+    }
+
+    /// <summary>
+    /// Client-side cache of prepared statements keyed by SQL text,
+    /// as used by ORMs that prepare a statement on every call.
+    /// </summary>
+    class StatementCache final
+    {
+    private:
+        Firebird::IAttachment* m_att;
+        std::unordered_map<std::string, Firebird::AutoRelease<Firebird::IStatement>> m_statements;
+        int64_t m_hits = 0;
+        int64_t m_misses = 0;
+    public:
+        explicit StatementCache(Firebird::IAttachment* att)
+            : m_att(att)
+        {}
+
+        // prepared is set to true when the statement is not found in the cache and is prepared now
+        Firebird::IStatement* prepare(Firebird::ThrowStatusWrapper* status, Firebird::ITransaction* tra, const std::string& sql, bool* prepared = nullptr)
+        {
+            if (auto it = m_statements.find(sql); it != m_statements.end()) {
+                ++m_hits;
+                return it->second;
+            }
+            ++m_misses;
+            if (prepared) {
+                *prepared = true;
+            }
+            Firebird::AutoRelease<Firebird::IStatement> stmt = m_att->prepare(status, tra, 0, sql.c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+            auto [it, inserted] = m_statements.emplace(sql, std::move(stmt));
+            return it->second;
+        }
+
+        void clear(Firebird::ThrowStatusWrapper* status)
+        {
+            for (auto& [sql, stmt] : m_statements) {
+                stmt->free(status);
+                stmt.release();
+            }
+            m_statements.clear();
+        }
+
+        int64_t hits() const { return m_hits; }
+        int64_t misses() const { return m_misses; }
+    };
+
+    struct PhaseStat {
+        int64_t count = 0;
+        std::chrono::nanoseconds elapsed{ 0 };
+    };
+
+    /// <summary>
+    /// Runs func and adds its time to the phase statistics. Only the clock is read,
+    /// so the wire counters of the test are not affected by the measurement.
+    /// </summary>
+    template <typename Func>
+    auto measurePhase(PhaseStat& phase, Func&& func)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        auto finish = [&]() {
+            phase.elapsed += std::chrono::steady_clock::now() - start;
+        };
+        if constexpr (std::is_void_v<decltype(func())>) {
+            func();
+            finish();
+        }
+        else {
+            auto result = func();
+            finish();
+            return result;
+        }
+    }
+
+    void printPhaseStat(const char* name, const PhaseStat& phase, int64_t calls)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+
+        const auto total = duration_cast<microseconds>(phase.elapsed);
+        std::cout << std::format("  {:<12} count = {:>7}, time = {:>10.3f} ms, per call = {:>8} us",
+            name, phase.count, total.count() / 1000.0, total.count() / std::max<int64_t>(calls, 1)) << std::endl;
+    }
+
+    enum class Statement_Reuse_Kind { PREPARE_PER_CALL, REUSE_STATEMENT, REUSE_STATEMENT_AND_TRANSACTION, STATEMENT_CACHE };
+
+    /// <summary>
+    /// Test the cost of statement preparation and transaction start per request.
+    /// Each call reads one BLOB by ID; the calls cycle through the point, short and long lookup
+    /// statements, so the statement cache has to find one of several statements.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="reuseKind">What is reused between calls</param>
+    /// <param name="calls">Number of calls</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
+    /// <param name="limit_rows">Limit on the number of keys</param>
+    /// <returns>Elapsed time, number of calls and wire statistics</returns>
+    TestResult testStatementReuse(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Statement_Reuse_Kind reuseKind,
+        int64_t calls, std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {})
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::high_resolution_clock;
+        using std::chrono::milliseconds;
+
+        const auto ids = loadIds(status, att, limit_rows);
+        if (ids.empty()) {
+            std::cout << "BLOB_TEST is empty" << std::endl;
+            return {};
+        }
+
+        const std::string lookupSql[] = { SQL_POINT_LOOKUP, SQL_SHORT_POINT_LOOKUP, SQL_LONG_POINT_LOOKUP };
+        for (const auto& sql : lookupSql) {
+            std::cout << "SQL:" << std::endl << sql << std::endl;
+        }
+
+        unsigned char tpb[] = { isc_tpb_version1, isc_tpb_read, isc_tpb_read_committed, isc_tpb_read_consistency };
+
+        // the same key sequence for every kind of reuse
+        std::mt19937_64 rnd(1);
+        std::uniform_int_distribution<size_t> keyDist(0, ids.size() - 1);
+
+        const bool reuseStatement = (reuseKind == Statement_Reuse_Kind::REUSE_STATEMENT) ||
+            (reuseKind == Statement_Reuse_Kind::REUSE_STATEMENT_AND_TRANSACTION);
+        const bool reuseTransaction = (reuseKind == Statement_Reuse_Kind::REUSE_STATEMENT_AND_TRANSACTION);
+
+        PhaseStat prepareStat;
+        PhaseStat executeStat;
+        PhaseStat transactionStat;
+        StatementCache cache(att);
+        Firebird::AutoRelease<Firebird::ITransaction> tra;
+        Firebird::AutoRelease<Firebird::IStatement> stmts[std::size(lookupSql)];
+
+        auto prepare = [&](size_t index) {
+            Firebird::IStatement* result = nullptr;
+            bool prepared = false;
+            if (reuseKind == Statement_Reuse_Kind::STATEMENT_CACHE) {
+                result = cache.prepare(status, tra, lookupSql[index], &prepared);
+            }
+            else {
+                stmts[index] = att->prepare(status, tra, 0, lookupSql[index].c_str(), 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+                result = stmts[index];
+                prepared = true;
+            }
+            // a cached statement keeps the setting
+            if (prepared && max_inline_blob_size.has_value() && result->cloopVTable->version >= result->VERSION) {
+                result->setMaxInlineBlobSize(status, max_inline_blob_size.value());
+            }
+            return result;
+        };
+
+        WireStartCollector wireStatCollector;
+
+        wireStatCollector.beginMonStat(status);
+        auto t0 = high_resolution_clock::now();
+
+        wireStatCollector.startStatCollect(status, att);
+
+        int64_t blb_size = 0;
+        int64_t not_found = 0;
+        for (int64_t i = 0; i < calls; i++) {
+            const size_t index = static_cast<size_t>(i) % std::size(lookupSql);
+            if (!tra) {
+                tra = measurePhase(transactionStat, [&] { return att->startTransaction(status, std::size(tpb), tpb); });
+                ++transactionStat.count;
+            }
+            Firebird::IStatement* current = stmts[index];
+            if (!current || !reuseStatement) {
+                current = measurePhase(prepareStat, [&] { return prepare(index); });
+                ++prepareStat.count;
+            }
+
+            const auto size = measurePhase(executeStat, [&] { return lookupBlob(status, att, tra, current, ids[keyDist(rnd)]); });
+            ++executeStat.count;
+            if (size < 0) {
+                ++not_found;
+            }
+            else {
+                blb_size += size;
+            }
+
+            if (!reuseStatement && reuseKind != Statement_Reuse_Kind::STATEMENT_CACHE) {
+                measurePhase(prepareStat, [&] { stmts[index]->free(status); });
+                stmts[index].release();
+            }
+            if (!reuseTransaction) {
+                measurePhase(transactionStat, [&] { tra->commit(status); });
+                tra.release();
+            }
+        }
+        if (tra) {
+            measurePhase(transactionStat, [&] { tra->commit(status); });
+            tra.release();
+        }
+
+        wireStatCollector.endStatCollect();
+
+        auto t1 = high_resolution_clock::now();
+        wireStatCollector.endMonStat(status);
+        auto elapsed = duration_cast<milliseconds>(t1 - t0);
+        std::cout << std::format("Elapsed time: {}", elapsed) << std::endl;
+        std::cout << "Calls: " << calls << std::endl;
+        // the short and long lookups do not find records of the other kind
+        std::cout << "Not found: " << not_found << std::endl;
+        std::cout << "Content size: " << blb_size << " bytes" << std::endl;
+        if (reuseKind == Statement_Reuse_Kind::STATEMENT_CACHE) {
+            std::cout << "Statement cache hits: " << cache.hits() << ", misses: " << cache.misses() << std::endl;
+        }
+        std::cout << std::format("Roundtrips per call: {:.2f}",
+            static_cast<double>(wireStatCollector.getWireStatDelta().wire_roundtrips) / static_cast<double>(std::max<int64_t>(calls, 1))) << std::endl;
+        std::cout << "Phases (free and commit are included in prepare and transaction):" << std::endl;
+        printPhaseStat("prepare", prepareStat, calls);
+        printPhaseStat("execute", executeStat, calls);
+        printPhaseStat("transaction", transactionStat, calls);
+        wireStatCollector.printWireStat();
+
+        const TestResult result{ duration_cast<std::chrono::microseconds>(t1 - t0), calls, wireStatCollector.getWireStatDelta() };
+
+        for (auto& stmt : stmts) {
+            if (stmt) {
+                stmt->free(status);
+                stmt.release();
+            }
+        }
+        cache.clear(status);
+
+        return result;
+    }
+
+    constexpr const char* SQL_UPDATE_CONTENT = R"(
+UPDATE BLOB_TEST
+SET CONTENT = ?
+WHERE ID = ?
+)";
+
+    bool isUpdateConflict(const Firebird::IStatus* st)
+    {
+        for (const intptr_t* v = st->getErrors(); v[0] != isc_arg_end; ) {
+            if (v[0] == isc_arg_gds && (v[1] == isc_update_conflict || v[1] == isc_deadlock || v[1] == isc_lock_conflict)) {
+                return true;
+            }
+            v += (v[0] == isc_arg_cstring) ? 3 : 2;
+        }
+        return false;
+    }
+
+    /// <summary>
+    /// Concurrent writer for BLOB_TEST. In its own thread and attachment it rewrites
+    /// CONTENT of random records with the same text, so the data stays intact, but every
+    /// update creates a new record version and a new BLOB and leaves the old ones as garbage.
+    /// </summary>
+    class BlobWriter final
+    {
+    private:
+        const AttachFactory& m_connect;
+        const std::vector<int64_t>& m_ids;
+        unsigned m_seed;
+        std::atomic<bool> m_stop = false;
+        std::atomic<int64_t> m_commits = 0;
+        std::atomic<int64_t> m_conflicts = 0;
+        std::vector<int64_t> m_commitLatency;
+        std::string m_error;
+        std::thread m_thread;
+    public:
+        BlobWriter(const AttachFactory& connect, const std::vector<int64_t>& ids, unsigned seed)
+            : m_connect(connect)
+            , m_ids(ids)
+            , m_seed(seed)
+        {}
+
+        BlobWriter(const BlobWriter&) = delete;
+        BlobWriter& operator=(const BlobWriter&) = delete;
+
+        ~BlobWriter()
+        {
+            stop();
+        }
+
+        void start()
+        {
+            m_stop = false;
+            m_thread = std::thread(&BlobWriter::run, this);
+        }
+
+        void stop()
+        {
+            m_stop = true;
+            if (m_thread.joinable()) {
+                m_thread.join();
+            }
+        }
+
+        int64_t commits() const { return m_commits; }
+        int64_t conflicts() const { return m_conflicts; }
+        // valid after stop()
+        std::vector<int64_t>& commitLatency() { return m_commitLatency; }
+        const std::string& error() const { return m_error; }
+    private:
+        void run();
+
+        void rewriteContent(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Firebird::ITransaction* tra,
+            Firebird::IStatement* selectStmt, Firebird::IStatement* updateStmt, int64_t id);
+    };
+
+    void BlobWriter::rewriteContent(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Firebird::ITransaction* tra,
+        Firebird::IStatement* selectStmt, Firebird::IStatement* updateStmt, int64_t id)
+    {
+        FB_MESSAGE(KeyMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+        ) key(status, master);
+
+        FB_MESSAGE(ContentMessage, Firebird::ThrowStatusWrapper,
+            (FB_BLOB, content)
+        ) content(status, master);
+
+        key->idNull = false;
+        key->id = id;
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = selectStmt->openCursor(status, tra, key.getMetadata(), key.getData(), content.getMetadata(), 0);
+        const bool found = (rs->fetchNext(status, content.getData()) == Firebird::IStatus::RESULT_OK);
+        rs->close(status);
+        rs.release();
+
+        if (!found || content->contentNull) {
+            return;
+        }
+
+        Firebird::AutoRelease<Firebird::IBlob> blob = att->openBlob(status, tra, &content->content, 0, nullptr);
+        const auto s = readBlob(status, blob);
+        blob->close(status);
+        blob.release();
+
+        FB_MESSAGE(UpdateMessage, Firebird::ThrowStatusWrapper,
+            (FB_BLOB, content)
+            (FB_BIGINT, id)
+        ) upd(status, master);
+
+        upd->contentNull = false;
+        upd->idNull = false;
+        upd->id = id;
+
+        Firebird::AutoRelease<Firebird::IBlob> newBlob = att->createBlob(status, tra, &upd->content, 0, nullptr);
+        for (size_t pos = 0; pos < s.size(); pos += MAX_SEGMENT_SIZE) {
+            const auto length = static_cast<unsigned int>(std::min<size_t>(MAX_SEGMENT_SIZE, s.size() - pos));
+            newBlob->putSegment(status, length, s.data() + pos);
+        }
+        newBlob->close(status);
+        newBlob.release();
+
+        updateStmt->execute(status, tra, upd.getMetadata(), upd.getData(), nullptr, nullptr);
+    }
+
+    void BlobWriter::run()
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        using std::chrono::steady_clock;
+
+        Firebird::AutoDispose<Firebird::IStatus> st = master->getStatus();
+        Firebird::ThrowStatusWrapper status(st);
+        try {
+            Firebird::AutoRelease<Firebird::IAttachment> att = m_connect(&status);
+
+            // nowait: concurrent writers report a conflict instead of waiting for each other
+            unsigned char tpb[] = { isc_tpb_version1, isc_tpb_write, isc_tpb_read_committed, isc_tpb_rec_version, isc_tpb_nowait };
+
+            Firebird::AutoRelease<Firebird::ITransaction> tra = att->startTransaction(&status, std::size(tpb), tpb);
+            Firebird::AutoRelease<Firebird::IStatement> selectStmt = att->prepare(&status, tra, 0, SQL_POINT_LOOKUP, 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+            Firebird::AutoRelease<Firebird::IStatement> updateStmt = att->prepare(&status, tra, 0, SQL_UPDATE_CONTENT, 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+            tra->commit(&status);
+            tra.release();
+
+            std::mt19937_64 rnd(m_seed);
+            std::uniform_int_distribution<size_t> keyDist(0, m_ids.size() - 1);
+
+            while (!m_stop) {
+                const auto t0 = steady_clock::now();
+                tra = att->startTransaction(&status, std::size(tpb), tpb);
+                try {
+                    rewriteContent(&status, att, tra, selectStmt, updateStmt, m_ids[keyDist(rnd)]);
+                    tra->commit(&status);
+                    tra.release();
+                    m_commitLatency.push_back(duration_cast<microseconds>(steady_clock::now() - t0).count());
+                    ++m_commits;
+                }
+                catch (const Firebird::FbException& e) {
+                    if (!isUpdateConflict(e.getStatus())) {
+                        throw;
+                    }
+                    ++m_conflicts;
+                    tra->rollback(&status);
+                    tra.release();
+                }
+            }
+
+            selectStmt->free(&status);
+            selectStmt.release();
+
+            updateStmt->free(&status);
+            updateStmt.release();
+
+            att->detach(&status);
+            att.release();
+        }
+        catch (const Firebird::FbException& e) {
+            char message_buffer[2048];
+            master->getUtilInterface()->formatStatus(message_buffer, static_cast<unsigned int>(std::size(message_buffer)), e.getStatus());
+            m_error = message_buffer;
+        }
+    }
+
+    struct TpbVariant {
+        const char* name;
+        std::vector<unsigned char> tpb;
+    };
+
+    // the variant that matches DEFAULT_READ_TPB, the reference row of the matrix summary
+    constexpr const char* DEFAULT_TPB_VARIANT = "read committed read_consistency, read only";
+
+    const std::vector<TpbVariant>& isolationVariants()
+    {
+        // wait is the default lock resolution, so no variant specifies it and the default one is exactly DEFAULT_READ_TPB
+        static const std::vector<TpbVariant> variants = {
+            { "snapshot, read only", { isc_tpb_version1, isc_tpb_read, isc_tpb_concurrency } },
+            { "snapshot, read write", { isc_tpb_version1, isc_tpb_write, isc_tpb_concurrency } },
+            { "read committed record_version, read only", { isc_tpb_version1, isc_tpb_read, isc_tpb_read_committed, isc_tpb_rec_version } },
+            { "read committed record_version, read write", { isc_tpb_version1, isc_tpb_write, isc_tpb_read_committed, isc_tpb_rec_version } },
+            { "read committed no_record_version, read only", { isc_tpb_version1, isc_tpb_read, isc_tpb_read_committed, isc_tpb_no_rec_version } },
+            { "read committed no_record_version, read write", { isc_tpb_version1, isc_tpb_write, isc_tpb_read_committed, isc_tpb_no_rec_version } },
+            { DEFAULT_TPB_VARIANT, { std::begin(DEFAULT_READ_TPB), std::end(DEFAULT_READ_TPB) } },
+            { "read committed read_consistency, read write", { isc_tpb_version1, isc_tpb_write, isc_tpb_read_committed, isc_tpb_read_consistency } }
+        };
+        return variants;
+    }
+
+    /// <summary>
+    /// Runs the BLOB read tests under each isolation level and access mode,
+    /// optionally while a concurrent writer updates BLOB_TEST.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment</param>
+    /// <param name="connect">Creates the writer attachment</param>
+    /// <param name="withWriter">Repeat the matrix with a concurrent writer</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
+    /// <param name="limit_rows">Limit on the number of rows returned by a query</param>
+    void testIsolationMatrix(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, const AttachFactory& connect,
+        bool withWriter, std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {})
+    {
+        struct MatrixRow {
+            std::string tpb;
+            bool writer;
+            const char* scenario;
+            TestResult result;
+        };
+        std::vector<MatrixRow> rows;
+
+        // the IDs are only needed to pick the records the writer updates
+        const auto ids = withWriter ? loadIds(status, att, limit_rows) : std::vector<int64_t>{};
+
+        for (const bool writer : { false, true }) {
+            if (writer && (!withWriter || ids.empty())) {
+                break;
+            }
+            std::optional<BlobWriter> blobWriter;
+            if (writer) {
+                blobWriter.emplace(connect, ids, 1);
+                blobWriter->start();
+            }
+            const std::string suffix = writer ? ", concurrent writer" : "";
+            for (const auto& variant : isolationVariants()) {
+                printTestHeader(std::format("Test read all BLOBs: {}{}", variant.name, suffix));
+                rows.push_back({ variant.name, writer, "all BLOBs",
+                    testWithReadBlob(status, att, Read_Blob_Kind::ALL_BLOB, max_inline_blob_size, limit_rows, variant.tpb) });
+
+                printTestHeader(std::format("Test read VARCHAR(8191): {}{}", variant.name, suffix));
+                rows.push_back({ variant.name, writer, "VARCHAR(8191)",
+                    testReadVarchar(status, att, limit_rows, variant.tpb) });
+
+                printTestHeader(std::format("Test read mixed BLOBs and VARCHARs with optimize: {}{}", variant.name, suffix));
+                rows.push_back({ variant.name, writer, "mixed optimized",
+                    testMixedRead(status, att, true, max_inline_blob_size, limit_rows, variant.tpb) });
+            }
+            if (blobWriter) {
+                blobWriter->stop();
+                const auto latency = summarizeLatency(blobWriter->commitLatency());
+                std::cout << std::endl << "Writer commits: " << blobWriter->commits() << ", conflicts: " << blobWriter->conflicts() << std::endl;
+                std::cout << std::format("Writer commit latency, ms: p50 = {:.2f}, p99 = {:.2f}, max = {:.2f}",
+                    latency.p50 / 1000.0, latency.p99 / 1000.0, latency.max / 1000.0) << std::endl;
+                if (!blobWriter->error().empty()) {
+                    std::cout << "Writer error: " << blobWriter->error() << std::endl;
+                }
+            }
+        }
+
+        auto findRow = [&rows](const std::string& tpb, bool writer, const char* scenario) -> const MatrixRow* {
+            auto it = std::find_if(rows.begin(), rows.end(), [&](const MatrixRow& row) {
+                return row.tpb == tpb && row.writer == writer && std::string_view(row.scenario) == scenario;
+            });
+            return it == rows.end() ? nullptr : &(*it);
+        };
+        // elapsed time difference from the reference row in ms and percent
+        auto delta = [](const TestResult& result, const MatrixRow* base) -> std::pair<std::string, std::string> {
+            if (!base) {
+                return { "-", "-" };
+            }
+            const auto diff = result.elapsed - base->result.elapsed;
+            return { std::format("{:+.1f}", diff.count() / 1000.0),
+                std::format("{:+.1f}", diff.count() * 100.0 / std::max<int64_t>(base->result.elapsed.count(), 1)) };
+        };
+
+        std::cout << std::endl << "Isolation matrix summary:" << std::endl;
+        std::cout << std::format("Deltas are relative to \"{}\" without the writer and to the same transaction without the writer.", DEFAULT_TPB_VARIANT) << std::endl;
+        std::cout << std::format("  {:<46} {:<6} {:<16} {:>12} {:>11} {:>14} {:>12} {:>10} {:>14} {:>12}",
+            "transaction", "writer", "test", "elapsed, ms", "roundtrips", "recv bytes",
+            "default, ms", "default, %", "no writer, ms", "no writer, %") << std::endl;
+        for (const auto& row : rows) {
+            const auto [defaultMs, defaultPercent] = delta(row.result, findRow(DEFAULT_TPB_VARIANT, false, row.scenario));
+            const auto [writerMs, writerPercent] = delta(row.result, row.writer ? findRow(row.tpb, false, row.scenario) : nullptr);
+            std::cout << std::format("  {:<46} {:<6} {:<16} {:>12.1f} {:>11} {:>14} {:>12} {:>10} {:>14} {:>12}",
+                row.tpb, row.writer ? "yes" : "no", row.scenario, row.result.elapsed.count() / 1000.0,
+                row.result.wire.wire_roundtrips, row.result.wire.wire_in_bytes,
+                defaultMs, defaultPercent, writerMs, writerPercent) << std::endl;
+        }
+    }
+
+    enum class Reader_Scenario { LOOKUP, SCAN };
+
+    const char* reader_scenario_name(Reader_Scenario scenario)
+    {
+        switch (scenario)
+        {
+        case Reader_Scenario::LOOKUP:
+            return "lookup";
+        case Reader_Scenario::SCAN:
+            return "scan";
+        default:
+            return "unknown";
+        }
+    }
+
+    /// <summary>
+    /// Reads all BLOBs of the prepared full read statement.
+    /// </summary>
+    /// <returns>Total content size</returns>
+    int64_t scanBlobs(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, Firebird::ITransaction* tra,
+        Firebird::IStatement* stmt)
+    {
+        FB_MESSAGE(OutMessage, Firebird::ThrowStatusWrapper,
+            (FB_BIGINT, id)
+            (FB_BLOB, content)
+        ) out(status, master);
+
+        Firebird::AutoRelease<Firebird::IResultSet> rs = stmt->openCursor(status, tra, nullptr, nullptr, out.getMetadata(), 0);
+
+        int64_t blb_size = 0;
+        while (rs->fetchNext(status, out.getData()) == Firebird::IStatus::RESULT_OK) {
+            if (!out->contentNull) {
+                Firebird::AutoRelease<Firebird::IBlob> blob = att->openBlob(status, tra, &out->content, 0, nullptr);
+                auto s = readBlob(status, blob);
+                blob->close(status);
+                blob.release();
+
+                blb_size += static_cast<int64_t>(s.size());
+            }
+        }
+
+        rs->close(status);
+        rs.release();
+
+        return blb_size;
+    }
+
+    /// <summary>
+    /// Mixed read/write workload. Reader threads repeat a BLOB read scenario while
+    /// 0, 1, 2, 4 ... writer threads rewrite CONTENT of random records, each thread
+    /// on its own attachment. Reader throughput and latency are compared with the run
+    /// without writers.
+    /// </summary>
+    /// <param name="status">Status</param>
+    /// <param name="att">Database attachment used to load the keys</param>
+    /// <param name="connect">Creates reader and writer attachments</param>
+    /// <param name="scenario">Operation repeated by the readers</param>
+    /// <param name="readers">Number of reader threads</param>
+    /// <param name="max_writers">Maximum number of writer threads</param>
+    /// <param name="duration">Duration of each step</param>
+    /// <param name="max_inline_blob_size">Max size of inline BLOB</param>
+    /// <param name="limit_rows">Limit on the number of keys and scanned rows</param>
+    void testConcurrentWorkload(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, const AttachFactory& connect,
+        Reader_Scenario scenario, unsigned readers, unsigned max_writers, std::chrono::seconds duration,
+        std::optional<unsigned short> max_inline_blob_size = {}, std::optional<uint64_t> limit_rows = {})
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        using std::chrono::steady_clock;
+
+        struct WorkloadStep {
+            unsigned writers = 0;
+            std::chrono::milliseconds elapsed{ 0 };
+            LatencySummary read;
+            int64_t readBytes = 0;
+            int64_t commits = 0;
+            int64_t conflicts = 0;
+            LatencySummary commit;
+        };
+
+        const auto ids = loadIds(status, att, limit_rows);
+        if (ids.empty()) {
+            std::cout << "BLOB_TEST is empty" << std::endl;
+            return;
+        }
+
+        std::string scanSql = SQL_ALL_BLOB_READ;
+        if (limit_rows.has_value()) {
+            scanSql += std::format("FETCH FIRST {} ROWS ONLY \n", limit_rows.value());
+        }
+        const char* readerSql = (scenario == Reader_Scenario::LOOKUP) ? SQL_POINT_LOOKUP : scanSql.c_str();
+
+        std::cout << "Reader SQL:" << std::endl << readerSql << std::endl;
+        std::cout << "Writer SQL:" << std::endl << SQL_UPDATE_CONTENT << std::endl;
+        std::cout << std::format("Reader scenario: {}, readers: {}, max writers: {}, step duration: {}, keys: {}",
+            reader_scenario_name(scenario), readers, max_writers, duration, ids.size()) << std::endl;
+
+        std::vector<unsigned> writerCounts{ 0 };
+        for (unsigned n = 1; n < max_writers; n *= 2) {
+            writerCounts.push_back(n);
+        }
+        if (max_writers > 0) {
+            writerCounts.push_back(max_writers);
+        }
+
+        std::vector<WorkloadStep> steps;
+        for (const unsigned writerCount : writerCounts) {
+            std::atomic<bool> stop = false;
+            std::vector<std::vector<int64_t>> latency(readers);
+            std::vector<int64_t> bytes(readers, 0);
+            std::vector<std::string> errors(readers);
+
+            // all readers attach before the step starts
+            std::vector<Firebird::AutoRelease<Firebird::IAttachment>> attachments;
+            attachments.reserve(readers);
+            for (unsigned i = 0; i < readers; i++) {
+                attachments.emplace_back(connect(status));
+            }
+
+            std::vector<std::unique_ptr<BlobWriter>> writers;
+            for (unsigned w = 0; w < writerCount; w++) {
+                writers.push_back(std::make_unique<BlobWriter>(connect, ids, w + 1));
+                writers.back()->start();
+            }
+
+            const auto t0 = steady_clock::now();
+            std::vector<std::thread> threads;
+            for (unsigned r = 0; r < readers; r++) {
+                threads.emplace_back([&, r]() {
+                    Firebird::AutoDispose<Firebird::IStatus> st = master->getStatus();
+                    Firebird::ThrowStatusWrapper readerStatus(st);
+                    auto& readerAtt = attachments[r];
+                    std::mt19937_64 rnd(r + 1);
+                    std::uniform_int_distribution<size_t> keyDist(0, ids.size() - 1);
+                    try {
+                        unsigned char tpb[] = { isc_tpb_version1, isc_tpb_read, isc_tpb_read_committed, isc_tpb_read_consistency };
+                        Firebird::AutoRelease<Firebird::ITransaction> tra = readerAtt->startTransaction(&readerStatus, std::size(tpb), tpb);
+                        Firebird::AutoRelease<Firebird::IStatement> stmt = readerAtt->prepare(&readerStatus, tra, 0, readerSql, 3, Firebird::IStatement::PREPARE_PREFETCH_METADATA);
+                        if (max_inline_blob_size.has_value() && stmt->cloopVTable->version >= stmt->VERSION) {
+                            stmt->setMaxInlineBlobSize(&readerStatus, max_inline_blob_size.value());
+                        }
+
+                        while (!stop) {
+                            const auto started = steady_clock::now();
+                            const int64_t size = (scenario == Reader_Scenario::LOOKUP)
+                                ? lookupBlob(&readerStatus, readerAtt, tra, stmt, ids[keyDist(rnd)])
+                                : scanBlobs(&readerStatus, readerAtt, tra, stmt);
+                            latency[r].push_back(duration_cast<microseconds>(steady_clock::now() - started).count());
+                            bytes[r] += std::max<int64_t>(size, 0);
+                        }
+
+                        stmt->free(&readerStatus);
+                        stmt.release();
+
+                        tra->commit(&readerStatus);
+                        tra.release();
+
+                        readerAtt->detach(&readerStatus);
+                        readerAtt.release();
+                    }
+                    catch (const Firebird::FbException& e) {
+                        char message_buffer[2048];
+                        master->getUtilInterface()->formatStatus(message_buffer, static_cast<unsigned int>(std::size(message_buffer)), e.getStatus());
+                        errors[r] = message_buffer;
+                    }
+                });
+            }
+
+            std::this_thread::sleep_for(duration);
+            stop = true;
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            const auto t1 = steady_clock::now();
+
+            WorkloadStep step;
+            step.writers = writerCount;
+            step.elapsed = duration_cast<std::chrono::milliseconds>(t1 - t0);
+            std::vector<int64_t> commitLatency;
+            for (auto& writer : writers) {
+                writer->stop();
+                step.commits += writer->commits();
+                step.conflicts += writer->conflicts();
+                commitLatency.insert(commitLatency.end(), writer->commitLatency().begin(), writer->commitLatency().end());
+                if (!writer->error().empty()) {
+                    std::cout << "Writer error: " << writer->error() << std::endl;
+                }
+            }
+            for (const auto& error : errors) {
+                if (!error.empty()) {
+                    std::cout << "Reader error: " << error << std::endl;
+                }
+            }
+            std::vector<int64_t> readLatency;
+            for (size_t r = 0; r < latency.size(); r++) {
+                readLatency.insert(readLatency.end(), latency[r].begin(), latency[r].end());
+                step.readBytes += bytes[r];
+            }
+            step.read = summarizeLatency(readLatency);
+            step.commit = summarizeLatency(commitLatency);
+
+            const double seconds = std::max<int64_t>(step.elapsed.count(), 1) / 1000.0;
+            std::cout << std::endl << std::format("Writers: {}, elapsed time: {}", writerCount, step.elapsed) << std::endl;
+            std::cout << std::format("Reads: {}, {:.1f} reads/s, {:.1f} MB/s", step.read.count,
+                step.read.count / seconds, step.readBytes / seconds / MEGABYTE) << std::endl;
+            std::cout << std::format("Read latency, ms: mean = {:.2f}, p50 = {:.2f}, p90 = {:.2f}, p99 = {:.2f}, max = {:.2f}",
+                step.read.mean / 1000.0, step.read.p50 / 1000.0, step.read.p90 / 1000.0, step.read.p99 / 1000.0, step.read.max / 1000.0) << std::endl;
+            if (writerCount > 0) {
+                std::cout << std::format("Writer commits: {}, {:.1f} commits/s, conflicts: {}", step.commits, step.commits / seconds, step.conflicts) << std::endl;
+                std::cout << std::format("Writer commit latency, ms: p50 = {:.2f}, p99 = {:.2f}, max = {:.2f}",
+                    step.commit.p50 / 1000.0, step.commit.p99 / 1000.0, step.commit.max / 1000.0) << std::endl;
+            }
+            steps.push_back(step);
+        }
+
+        const auto& base = steps.front();
+        const double baseSeconds = std::max<int64_t>(base.elapsed.count(), 1) / 1000.0;
+        const double baseRate = base.read.count / baseSeconds;
+        auto ratio = [](double value, double baseline) {
+            return baseline > 0 ? value / baseline : 0.0;
+        };
+
+        std::cout << std::endl << "Workload summary:" << std::endl;
+        std::cout << std::format("  {:>7} {:>10} {:>8} {:>9} {:>9} {:>8} {:>8} {:>10} {:>9} {:>9}",
+            "writers", "reads/s", "x rate", "p50, ms", "p99, ms", "x p50", "x p99", "commits/s", "conflicts", "c99, ms") << std::endl;
+        for (const auto& step : steps) {
+            const double seconds = std::max<int64_t>(step.elapsed.count(), 1) / 1000.0;
+            const double rate = step.read.count / seconds;
+            std::cout << std::format("  {:>7} {:>10.1f} {:>8.2f} {:>9.2f} {:>9.2f} {:>8.2f} {:>8.2f} {:>10.1f} {:>9} {:>9.2f}",
+                step.writers, rate, ratio(rate, baseRate),
+                step.read.p50 / 1000.0, step.read.p99 / 1000.0,
+                ratio(static_cast<double>(step.read.p50), static_cast<double>(base.read.p50)),
+                ratio(static_cast<double>(step.read.p99), static_cast<double>(base.read.p99)),
+                step.commits / seconds, step.conflicts, step.commit.p99 / 1000.0) << std::endl;
+        }
+    }
+
+    /// <summary>
+    /// Minimal JSON value, enough to read back the results files written by this tool.
+    /// </summary>
+    struct JsonValue {
+        enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+        Type type = Type::NUL;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<JsonValue> array;
+        std::vector<std::pair<std::string, JsonValue>> object;
+
+        const JsonValue* find(const std::string& key) const
+        {
+            for (const auto& [name, value] : object) {
+                if (name == key) {
+                    return &value;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    class JsonParser final
+    {
+    private:
+        const std::string& m_text;
+        size_t m_pos = 0;
+    public:
+        explicit JsonParser(const std::string& text)
+            : m_text(text)
+        {}
+
+        JsonValue parse()
+        {
+            auto value = parseValue();
+            skipSpaces();
+            if (m_pos != m_text.size()) {
+                error("unexpected data after the value");
+            }
+            return value;
+        }
+    private:
+        [[noreturn]] void error(const std::string& message) const
+        {
+            throw std::runtime_error(std::format("JSON error at position {}: {}", m_pos, message));
+        }
+
+        void skipSpaces()
+        {
+            while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+                ++m_pos;
+            }
+        }
+
+        bool consume(char c)
+        {
+            skipSpaces();
+            if (m_pos < m_text.size() && m_text[m_pos] == c) {
+                ++m_pos;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(char c)
+        {
+            if (!consume(c)) {
+                error(std::string("expected '") + c + "'");
+            }
+        }
+
+        bool consumeWord(const char* word)
+        {
+            const size_t length = std::strlen(word);
+            if (m_text.compare(m_pos, length, word) == 0) {
+                m_pos += length;
+                return true;
+            }
+            return false;
+        }
+
+        JsonValue parseValue()
+        {
+            skipSpaces();
+            if (m_pos >= m_text.size()) {
+                error("unexpected end of data");
+            }
+            JsonValue value;
+            const char c = m_text[m_pos];
+            if (c == '{') {
+                ++m_pos;
+                value.type = JsonValue::Type::OBJECT;
+                if (consume('}')) {
+                    return value;
+                }
+                do {
+                    skipSpaces();
+                    auto key = parseString();
+                    expect(':');
+                    value.object.emplace_back(std::move(key), parseValue());
+                } while (consume(','));
+                expect('}');
+            }
+            else if (c == '[') {
+                ++m_pos;
+                value.type = JsonValue::Type::ARRAY;
+                if (consume(']')) {
+                    return value;
+                }
+                do {
+                    value.array.push_back(parseValue());
+                } while (consume(','));
+                expect(']');
+            }
+            else if (c == '"') {
+                value.type = JsonValue::Type::STRING;
+                value.string = parseString();
+            }
+            else if (consumeWord("true")) {
+                value.type = JsonValue::Type::BOOLEAN;
+                value.boolean = true;
+            }
+            else if (consumeWord("false")) {
+                value.type = JsonValue::Type::BOOLEAN;
+            }
+            else if (consumeWord("null")) {
+                value.type = JsonValue::Type::NUL;
+            }
+            else {
+                const char* begin = m_text.c_str() + m_pos;
+                char* end = nullptr;
+                value.type = JsonValue::Type::NUMBER;
+                value.number = std::strtod(begin, &end);
+                if (end == begin) {
+                    error("invalid value");
+                }
+                m_pos += static_cast<size_t>(end - begin);
+            }
+            return value;
+        }
+
+        std::string parseString()
+        {
+            if (m_pos >= m_text.size() || m_text[m_pos] != '"') {
+                error("expected string");
+            }
+            ++m_pos;
+            std::string s;
+            while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+                char c = m_text[m_pos++];
+                if (c == '\\' && m_pos < m_text.size()) {
+                    c = m_text[m_pos++];
+                    switch (c) {
+                    case 'n':
+                        c = '\n';
+                        break;
+                    case 't':
+                        c = '\t';
+                        break;
+                    case 'r':
+                        c = '\r';
+                        break;
+                    case 'u':
+                        // only ASCII escapes are written by this tool
+                        if (m_text.size() - m_pos < 4 ||
+                            !std::all_of(m_text.begin() + m_pos, m_text.begin() + m_pos + 4, [](char h) { return std::isxdigit(static_cast<unsigned char>(h)) != 0; }))
+                        {
+                            error("invalid \\u escape");
+                        }
+                        c = static_cast<char>(std::stoi(m_text.substr(m_pos, 4), nullptr, 16));
+                        m_pos += 4;
+                        break;
+                    default:
+                        break;
+                    }
+                }
+                s += c;
+            }
+            if (m_pos >= m_text.size()) {
+                error("unterminated string");
+            }
+            ++m_pos;
+            return s;
+        }
+    };
+
+    std::string json_quote(const std::string& s)
+    {
+        std::string result = "\"";
+        for (const char c : s) {
+            switch (c) {
+            case '"':
+                result += "\\\"";
+                break;
+            case '\\':
+                result += "\\\\";
+                break;
+            case '\n':
+                result += "\\n";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    result += std::format("\\u{:04x}", static_cast<int>(c));
+                }
+                else {
+                    result += c;
+                }
+            }
+        }
+        return result + "\"";
+    }
+
+    struct ResultMetric {
+        const char* name;
+        int64_t (*value)(const TestResult& result);
+        void (*assign)(TestResult& result, int64_t value);
+    };
+
+    // metrics stored in the results file and compared with the baseline, lower is better
+    constexpr ResultMetric RESULT_METRICS[] = {
+        { "elapsed_us",
+            [](const TestResult& r) -> int64_t { return r.elapsed.count(); },
+            [](TestResult& r, int64_t v) { r.elapsed = std::chrono::microseconds(v); } },
+        { "roundtrips",
+            [](const TestResult& r) -> int64_t { return r.wire.wire_roundtrips; },
+            [](TestResult& r, int64_t v) { r.wire.wire_roundtrips = v; } },
+        { "recv_bytes",
+            [](const TestResult& r) -> int64_t { return r.wire.wire_in_bytes; },
+            [](TestResult& r, int64_t v) { r.wire.wire_in_bytes = v; } },
+        { "recv_wire_bytes",
+            [](const TestResult& r) -> int64_t { return r.wire.wire_rcv_bytes; },
+            [](TestResult& r, int64_t v) { r.wire.wire_rcv_bytes = v; } }
+    };
+
+    /// <summary>
+    /// Results of all iterations of each test, in the order the tests were run.
+    /// </summary>
+    class ResultLog final
+    {
+    public:
+        struct Scenario {
+            std::string name;
+            std::vector<TestResult> samples;
+        };
+    private:
+        std::vector<Scenario> m_scenarios;
+    public:
+        void add(const std::string& name, const TestResult& result)
+        {
+            auto it = std::find_if(m_scenarios.begin(), m_scenarios.end(), [&name](const Scenario& s) { return s.name == name; });
+            if (it == m_scenarios.end()) {
+                it = m_scenarios.insert(m_scenarios.end(), Scenario{ name, {} });
+            }
+            it->samples.push_back(result);
+        }
+
+        const std::vector<Scenario>& scenarios() const
+        {
+            return m_scenarios;
+        }
+
+        const Scenario* find(const std::string& name) const
+        {
+            auto it = std::find_if(m_scenarios.begin(), m_scenarios.end(), [&name](const Scenario& s) { return s.name == name; });
+            return it == m_scenarios.end() ? nullptr : &(*it);
+        }
+
+        void save(const std::string& fileName) const;
+
+        static ResultLog load(const std::string& fileName);
+    };
+
+    void ResultLog::save(const std::string& fileName) const
+    {
+        std::ofstream out(fileName, std::ios::out | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Cannot create results file " + fileName);
+        }
+        out << "{\n  \"version\": 1,\n  \"scenarios\": [";
+        for (size_t i = 0; i < m_scenarios.size(); i++) {
+            const auto& scenario = m_scenarios[i];
+            out << (i ? "," : "") << "\n    {\n      \"name\": " << json_quote(scenario.name);
+            for (const auto& metric : RESULT_METRICS) {
+                out << ",\n      \"" << metric.name << "\": [";
+                for (size_t j = 0; j < scenario.samples.size(); j++) {
+                    out << (j ? ", " : "") << metric.value(scenario.samples[j]);
+                }
+                out << "]";
+            }
+            out << "\n    }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    ResultLog ResultLog::load(const std::string& fileName)
+    {
+        std::ifstream in(fileName);
+        if (!in) {
+            throw std::runtime_error("Cannot open baseline file " + fileName);
+        }
+        const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        const auto root = JsonParser(text).parse();
+        const auto* scenarios = root.find("scenarios");
+        if (!scenarios || scenarios->type != JsonValue::Type::ARRAY) {
+            throw std::runtime_error("No scenarios in baseline file " + fileName);
+        }
+
+        ResultLog log;
+        for (const auto& scenario : scenarios->array) {
+            const auto* name = scenario.find("name");
+            if (!name || name->type != JsonValue::Type::STRING) {
+                continue;
+            }
+            std::vector<TestResult> samples;
+            // the i-th element of every metric array belongs to the i-th run
+            std::optional<size_t> sampleCount;
+            bool consistent = true;
+            for (const auto& metric : RESULT_METRICS) {
+                const auto* values = scenario.find(metric.name);
+                if (!values || values->type != JsonValue::Type::ARRAY) {
+                    continue;
+                }
+                if (sampleCount.has_value() && sampleCount.value() != values->array.size()) {
+                    consistent = false;
+                    break;
+                }
+                sampleCount = values->array.size();
+                samples.resize(values->array.size(), TestResult{});
+                for (size_t i = 0; i < values->array.size(); i++) {
+                    metric.assign(samples[i], static_cast<int64_t>(values->array[i].number));
+                }
+            }
+            if (!consistent) {
+                std::cerr << std::format("Warning: scenario \"{}\" in {} is skipped, its metric arrays differ in length", name->string, fileName) << std::endl;
+                continue;
+            }
+            for (const auto& sample : samples) {
+                log.add(name->string, sample);
+            }
+        }
+        return log;
+    }
+
+    /// <summary>
+    /// Regularized incomplete beta function I_x(a, b), continued fraction from Numerical Recipes.
+    /// </summary>
+    double incomplete_beta(double a, double b, double x)
+    {
+        if (x <= 0.0) {
+            return 0.0;
+        }
+        if (x >= 1.0) {
+            return 1.0;
+        }
+        if (x > (a + 1.0) / (a + b + 2.0)) {
+            return 1.0 - incomplete_beta(b, a, 1.0 - x);
+        }
+        const double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1.0 - x)) / a;
+
+        constexpr double TINY = 1e-30;
+        double c = 1.0;
+        double d = 1.0 - (a + b) * x / (a + 1.0);
+        d = 1.0 / (std::abs(d) < TINY ? TINY : d);
+        double f = d;
+        for (int m = 1; m <= 200; m++) {
+            // even step
+            double numerator = m * (b - m) * x / ((a + 2.0 * m - 1.0) * (a + 2.0 * m));
+            d = 1.0 + numerator * d;
+            d = 1.0 / (std::abs(d) < TINY ? TINY : d);
+            c = 1.0 + numerator / c;
+            c = std::abs(c) < TINY ? TINY : c;
+            f *= c * d;
+            // odd step
+            numerator = -(a + m) * (a + b + m) * x / ((a + 2.0 * m) * (a + 2.0 * m + 1.0));
+            d = 1.0 + numerator * d;
+            d = 1.0 / (std::abs(d) < TINY ? TINY : d);
+            c = 1.0 + numerator / c;
+            c = std::abs(c) < TINY ? TINY : c;
+            const double delta = c * d;
+            f *= delta;
+            if (std::abs(delta - 1.0) < 1e-10) {
+                break;
+            }
+        }
+        return front * f;
+    }
+
+    /// <summary>
+    /// Two-sided p-value of Welch's t-test for the difference of means.
+    /// Returns nothing if there are not enough samples for the test.
+    /// </summary>
+    std::optional<double> welch_t_test(const std::vector<double>& x, const std::vector<double>& y)
+    {
+        if (x.size() < 2 || y.size() < 2) {
+            return {};
+        }
+        auto meanVar = [](const std::vector<double>& v) {
+            const double mean = std::accumulate(v.begin(), v.end(), 0.0) / static_cast<double>(v.size());
+            double sq = 0.0;
+            for (const double value : v) {
+                sq += (value - mean) * (value - mean);
+            }
+            return std::pair{ mean, sq / static_cast<double>(v.size() - 1) };
+        };
+        const auto [mx, vx] = meanVar(x);
+        const auto [my, vy] = meanVar(y);
+        const double sx = vx / static_cast<double>(x.size());
+        const double sy = vy / static_cast<double>(y.size());
+        if (sx + sy == 0.0) {
+            // both samples are constant
+            return (mx == my) ? 1.0 : 0.0;
+        }
+        const double t = (mx - my) / std::sqrt(sx + sy);
+        const double df = (sx + sy) * (sx + sy) /
+            (sx * sx / static_cast<double>(x.size() - 1) + sy * sy / static_cast<double>(y.size() - 1));
+        return incomplete_beta(df / 2.0, 0.5, df / (df + t * t));
+    }
+
+    /// <summary>
+    /// Compares the current results with a baseline. A metric is a regression when its mean
+    /// grew by more than the threshold and Welch's t-test rejects equal means at the 0.05 level.
+    /// With a single iteration on either side only the threshold is checked.
+    /// </summary>
+    /// <returns>Number of regressions</returns>
+    int compareWithBaseline(const ResultLog& baseline, const ResultLog& current, double thresholdPercent)
+    {
+        constexpr double ALPHA = 0.05;
+
+        std::cout << std::format("Threshold: {}%, significance level: {}", thresholdPercent, ALPHA) << std::endl;
+        std::cout << std::format("  {:<52} {:<16} {:>14} {:>14} {:>9} {:>8}  {}",
+            "test", "metric", "baseline", "current", "change", "p-value", "verdict") << std::endl;
+
+        int regressions = 0;
+        for (const auto& scenario : current.scenarios()) {
+            const auto* base = baseline.find(scenario.name);
+            if (!base) {
+                std::cout << std::format("  {:<52} not in baseline", scenario.name) << std::endl;
+                continue;
+            }
+            for (const auto& metric : RESULT_METRICS) {
+                std::vector<double> x;
+                std::vector<double> y;
+                for (const auto& sample : base->samples) {
+                    x.push_back(static_cast<double>(metric.value(sample)));
+                }
+                for (const auto& sample : scenario.samples) {
+                    y.push_back(static_cast<double>(metric.value(sample)));
+                }
+                const double mx = std::accumulate(x.begin(), x.end(), 0.0) / static_cast<double>(x.size());
+                const double my = std::accumulate(y.begin(), y.end(), 0.0) / static_cast<double>(y.size());
+                if (mx == 0.0 && my == 0.0) {
+                    continue;
+                }
+                const double change = (mx == 0.0) ? 100.0 : (my - mx) * 100.0 / mx;
+                const auto pValue = welch_t_test(x, y);
+                const bool significant = !pValue.has_value() || pValue.value() < ALPHA;
+
+                const char* verdict = "ok";
+                if (std::abs(change) > thresholdPercent && significant) {
+                    if (change > 0) {
+                        verdict = "REGRESSION";
+                        ++regressions;
+                    }
+                    else {
+                        verdict = "improvement";
+                    }
+                }
+                std::cout << std::format("  {:<52} {:<16} {:>14.0f} {:>14.0f} {:>8.1f}% {:>8}  {}",
+                    scenario.name, metric.name, mx, my, change,
+                    pValue.has_value() ? std::format("{:.4f}", pValue.value()) : std::string("n/a"), verdict) << std::endl;
+            }
+        }
+        return regressions;
     }
 
     struct VCallback : public Firebird::IVersionCallbackImpl<VCallback, Firebird::ThrowStatusWrapper>
@@ -685,7 +4449,8 @@ FROM BLOB_TEST
         }
     };
 
-    enum class OptState { NONE, DATABASE, USERNAME, PASSWORD, CHARSET, MAX_INLINE_BLOB_SIZE, ROWS_LIMIT };
+    enum class OptState { NONE, DATABASE, USERNAME, PASSWORD, CHARSET, MAX_INLINE_BLOB_SIZE, ROWS_LIMIT, TRACE_FILE, RECORD_FILE, REPLAY_FILE, ENGINE,
+        LOAD_RATE, LOAD_DURATION, LOAD_CONNECTIONS, WORKLOAD_READERS, WORKLOAD_WRITERS, WORKLOAD_SCENARIO, REUSE_CALLS, LOOKUPS, KEY_DISTRIBUTION, BLOB_CACHE, SPANS, ITERATIONS, RESULTS_FILE, BASELINE_FILE, THRESHOLD };
 
     constexpr char HELP_INFO[] = R"(
 Usage fb-blob-test [<database>] <options>
@@ -701,6 +4466,48 @@ Database options:
     -i [ --max-inline-blob-size ] value  Maximum inline blob size, default 65535
     -z [ --compress ]                    Wire compression, default False
     -a [ --auto-blob-inline ]            Set optimal maximum inline blob size for each statement
+
+Test options:
+    --chunked-read                       Also read documents stored as VARCHAR chunks in BLOB_TEST_CHUNK
+    --packed                             Also read LZ4-compressed documents from BLOB_TEST_PACKED, fill it if empty
+    --two-phase                          Also read lengths first, then short values as VARCHAR batches and long ones as BLOBs
+    --mon-stat                           Print server I/O and record statistics from MON$ tables
+    --trace file                         Write a CSV timeline of fetches and BLOB calls with wire deltas
+    --alloc-stat                         Print client allocation count, bytes and peak heap for each test
+    --perf-stat                          Print client CPU cycles, instructions, cache and branch misses (Linux)
+    --columnar                           Compare filling and scanning a result with per-row strings and by columns
+    --deferred-blobs                     Read all BLOBs in groups of 1, 4, 16, 64 and 256 rows with deferred open/close
+    --server-blobs                       Read BLOBs created by CAST, concatenation, BLOB_APPEND, string functions and LIST
+    --size-buckets                       Break down BLOB read time, roundtrips and inline hits by BLOB size
+    --spans value                        Aggregate fetch and BLOB call spans, reading wire counters every N-th call
+    --reuse-calls value                  Compare statement and transaction reuse on the given number of BLOB lookups
+    --lookups value                      Run the given number of BLOB lookups by random ID with and without inline BLOBs
+    --key-distribution name              Lookup key distribution: uniform, zipfian or hotset, default all
+    --blob-cache value                   Repeat the lookups with a client LRU cache of BLOB contents, size in megabytes
+    --isolation-matrix                   Repeat the read tests under each isolation level and access mode
+    --matrix-writer                      Also run the isolation matrix while a writer updates BLOB_TEST
+
+Record options:
+    --record file                        Save rows and BLOB segments of the optimized mixed read to a file
+    --replay file                        Replay a recording through the client-side consumers without a server
+
+Result options:
+    --iterations value                   Number of runs of the read tests, default 1
+    --results file                       Save the read test results to a JSON file
+    --compare-providers                  Run the read tests through the embedded engine and inet://localhost
+    --engine name                        Engine provider of --compare-providers, default Engine13 (Engine12 on Firebird 3)
+    --baseline file                      Compare the read test results with a previously saved JSON file,
+                                         exit code 2 on regression
+    --threshold value                    Regression threshold in percent, default 10
+
+Load options:
+    --load-rate value                    Run open-loop BLOB lookups at the given rate, requests per second
+    --load-duration value                Load test duration in seconds, default 30
+    --load-connections value             Number of attachments issuing the load, default 4
+    --workload-readers value             Run the given number of readers against 0, 1, 2, 4 ... concurrent writers,
+                                         each step lasts --load-duration
+    --workload-writers value             Maximum number of writers of the workload, default 4
+    --workload-scenario name             Reader scenario of the workload: lookup or scan, default lookup
 )";
 
     class TestApp final
@@ -714,6 +4521,45 @@ Database options:
         std::optional<uint64_t> m_limit_rows;
         bool m_wireCompression = false;
         bool m_autoBlobInline = false;
+        // test options
+        bool m_chunkedRead = false;
+        bool m_packed = false;
+        bool m_twoPhase = false;
+        bool m_deferredBlobs = false;
+        bool m_serverBlobs = false;
+        bool m_columnar = false;
+        bool m_monStat = false;
+        std::string m_traceFile;
+        bool m_allocStat = false;
+        bool m_sizeBuckets = false;
+        bool m_perfStat = false;
+        std::optional<unsigned> m_spanSample;
+        std::optional<int64_t> m_reuseCalls;
+        std::optional<int64_t> m_lookups;
+        std::optional<size_t> m_blobCacheSize;
+        std::vector<Key_Distribution> m_keyDistributions{ Key_Distribution::UNIFORM, Key_Distribution::ZIPFIAN, Key_Distribution::HOTSET };
+        bool m_isolationMatrix = false;
+        bool m_matrixWriter = false;
+        // record options
+        std::string m_recordFile;
+        std::string m_replayFile;
+        // result options
+        unsigned m_iterations = 1;
+        std::string m_resultsFile;
+        std::string m_baselineFile;
+        double m_threshold = 10.0;
+        ResultLog m_results;
+        // prepended to test titles when the same tests are run more than once
+        std::string m_titlePrefix;
+        bool m_compareProviders = false;
+        std::string m_engineProvider{ "Engine13" };
+        // load options
+        std::optional<double> m_loadRate;
+        unsigned m_loadDuration = 30;
+        unsigned m_loadConnections = 4;
+        std::optional<unsigned> m_workloadReaders;
+        unsigned m_workloadWriters = 4;
+        Reader_Scenario m_workloadScenario = Reader_Scenario::LOOKUP;
     public:
         int exec(int argc, const char** argv);
     private:
@@ -725,12 +4571,25 @@ Database options:
 
         int run();
 
+        int runReplay();
+
+        void runScanTests(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, ResultLog& results);
+
+        void compareProviders(Firebird::ThrowStatusWrapper* status, Firebird::IProvider* provider);
+
         void parseArgs(int argc, const char** argv);
+
+        void setKeyDistribution(const std::string& name);
+
+        void setWorkloadScenario(const std::string& name);
     };
 
     int TestApp::exec(int argc, const char** argv)
     {
         parseArgs(argc, argv);
+        if (!m_replayFile.empty()) {
+            return runReplay();
+        }
         return run();
     }
 
@@ -819,6 +4678,134 @@ Database options:
                     m_autoBlobInline = true;
                     continue;
                 }
+                if (arg == "--chunked-read") {
+                    m_chunkedRead = true;
+                    continue;
+                }
+                if (arg == "--packed") {
+                    m_packed = true;
+                    continue;
+                }
+                if (arg == "--two-phase") {
+                    m_twoPhase = true;
+                    continue;
+                }
+                if (arg == "--columnar") {
+                    m_columnar = true;
+                    continue;
+                }
+                if (arg == "--deferred-blobs") {
+                    m_deferredBlobs = true;
+                    continue;
+                }
+                if (arg == "--server-blobs") {
+                    m_serverBlobs = true;
+                    continue;
+                }
+                if (arg == "--mon-stat") {
+                    m_monStat = true;
+                    continue;
+                }
+                if (arg == "--perf-stat") {
+                    m_perfStat = true;
+                    continue;
+                }
+                if (arg == "--size-buckets") {
+                    m_sizeBuckets = true;
+                    continue;
+                }
+                if (arg == "--alloc-stat") {
+                    m_allocStat = true;
+                    continue;
+                }
+                if (arg == "--trace") {
+                    st = OptState::TRACE_FILE;
+                    continue;
+                }
+                if (arg == "--isolation-matrix") {
+                    m_isolationMatrix = true;
+                    continue;
+                }
+                if (arg == "--matrix-writer") {
+                    m_matrixWriter = true;
+                    continue;
+                }
+                if (arg == "--reuse-calls") {
+                    st = OptState::REUSE_CALLS;
+                    continue;
+                }
+                if (arg == "--spans") {
+                    st = OptState::SPANS;
+                    continue;
+                }
+                if (arg == "--lookups") {
+                    st = OptState::LOOKUPS;
+                    continue;
+                }
+                if (arg == "--key-distribution") {
+                    st = OptState::KEY_DISTRIBUTION;
+                    continue;
+                }
+                if (arg == "--blob-cache") {
+                    st = OptState::BLOB_CACHE;
+                    continue;
+                }
+                if (arg == "--record") {
+                    st = OptState::RECORD_FILE;
+                    continue;
+                }
+                if (arg == "--replay") {
+                    st = OptState::REPLAY_FILE;
+                    continue;
+                }
+                if (arg == "--compare-providers") {
+                    m_compareProviders = true;
+                    continue;
+                }
+                if (arg == "--engine") {
+                    st = OptState::ENGINE;
+                    continue;
+                }
+                if (arg == "--iterations") {
+                    st = OptState::ITERATIONS;
+                    continue;
+                }
+                if (arg == "--results") {
+                    st = OptState::RESULTS_FILE;
+                    continue;
+                }
+                if (arg == "--baseline") {
+                    st = OptState::BASELINE_FILE;
+                    continue;
+                }
+                if (arg == "--threshold") {
+                    st = OptState::THRESHOLD;
+                    continue;
+                }
+                if (arg == "--load-rate") {
+                    st = OptState::LOAD_RATE;
+                    continue;
+                }
+                if (arg == "--load-duration") {
+                    st = OptState::LOAD_DURATION;
+                    continue;
+                }
+                if (arg == "--load-connections") {
+                    st = OptState::LOAD_CONNECTIONS;
+                    continue;
+                }
+                if (arg == "--workload-readers") {
+                    st = OptState::WORKLOAD_READERS;
+                    continue;
+                }
+                if (arg == "--workload-writers") {
+                    st = OptState::WORKLOAD_WRITERS;
+                    continue;
+                }
+                if (arg == "--workload-scenario") {
+                    st = OptState::WORKLOAD_SCENARIO;
+                    continue;
+                }
                 if (auto pos = arg.find("--database="); pos == 0) {
                     m_database.assign(arg.substr(11));
                     continue;
@@ -845,6 +4832,82 @@ Database options:
                     m_limit_rows = static_cast<uint64_t>(std::stoull(s_limit_rows));
                     continue;
                 }
+                if (auto pos = arg.find("--trace="); pos == 0) {
+                    m_traceFile.assign(arg.substr(8));
+                    continue;
+                }
+                if (auto pos = arg.find("--reuse-calls="); pos == 0) {
+                    m_reuseCalls = std::stoll(arg.substr(14));
+                    continue;
+                }
+                if (auto pos = arg.find("--spans="); pos == 0) {
+                    m_spanSample = static_cast<unsigned>(std::stoul(arg.substr(8)));
+                    continue;
+                }
+                if (auto pos = arg.find("--lookups="); pos == 0) {
+                    m_lookups = std::stoll(arg.substr(10));
+                    continue;
+                }
+                if (auto pos = arg.find("--key-distribution="); pos == 0) {
+                    setKeyDistribution(arg.substr(19));
+                    continue;
+                }
+                if (auto pos = arg.find("--blob-cache="); pos == 0) {
+                    m_blobCacheSize = std::stoull(arg.substr(13)) * MEGABYTE;
+                    continue;
+                }
+                if (auto pos = arg.find("--engine="); pos == 0) {
+                    m_engineProvider.assign(arg.substr(9));
+                    continue;
+                }
+                if (auto pos = arg.find("--record="); pos == 0) {
+                    m_recordFile.assign(arg.substr(9));
+                    continue;
+                }
+                if (auto pos = arg.find("--replay="); pos == 0) {
+                    m_replayFile.assign(arg.substr(9));
+                    continue;
+                }
+                if (auto pos = arg.find("--iterations="); pos == 0) {
+                    m_iterations = static_cast<unsigned>(std::stoul(arg.substr(13)));
+                    continue;
+                }
+                if (auto pos = arg.find("--results="); pos == 0) {
+                    m_resultsFile.assign(arg.substr(10));
+                    continue;
+                }
+                if (auto pos = arg.find("--baseline="); pos == 0) {
+                    m_baselineFile.assign(arg.substr(11));
+                    continue;
+                }
+                if (auto pos = arg.find("--threshold="); pos == 0) {
+                    m_threshold = std::stod(arg.substr(12));
+                    continue;
+                }
+                if (auto pos = arg.find("--load-rate="); pos == 0) {
+                    m_loadRate = std::stod(arg.substr(12));
+                    continue;
+                }
+                if (auto pos = arg.find("--load-duration="); pos == 0) {
+                    m_loadDuration = static_cast<unsigned>(std::stoul(arg.substr(16)));
+                    continue;
+                }
+                if (auto pos = arg.find("--load-connections="); pos == 0) {
+                    m_loadConnections = static_cast<unsigned>(std::stoul(arg.substr(19)));
+                    continue;
+                }
+                if (auto pos = arg.find("--workload-readers="); pos == 0) {
+                    m_workloadReaders = static_cast<unsigned>(std::stoul(arg.substr(19)));
+                    continue;
+                }
+                if (auto pos = arg.find("--workload-writers="); pos == 0) {
+                    m_workloadWriters = static_cast<unsigned>(std::stoul(arg.substr(19)));
+                    continue;
+                }
+                if (auto pos = arg.find("--workload-scenario="); pos == 0) {
+                    setWorkloadScenario(arg.substr(20));
+                    continue;
+                }
                 std::cerr << "Error: unrecognized option '" << arg << "'. See: --help" << std::endl;
                 exit(-1);
             }
@@ -873,15 +4936,243 @@ Database options:
                 case OptState::ROWS_LIMIT:
                     m_limit_rows = static_cast<uint64_t>(std::stoull(arg));
                     break;
+                case OptState::TRACE_FILE:
+                    m_traceFile.assign(arg);
+                    break;
+                case OptState::ENGINE:
+                    m_engineProvider.assign(arg);
+                    break;
+                case OptState::REUSE_CALLS:
+                    m_reuseCalls = std::stoll(arg);
+                    break;
+                case OptState::SPANS:
+                    m_spanSample = static_cast<unsigned>(std::stoul(arg));
+                    break;
+                case OptState::LOOKUPS:
+                    m_lookups = std::stoll(arg);
+                    break;
+                case OptState::KEY_DISTRIBUTION:
+                    setKeyDistribution(arg);
+                    break;
+                case OptState::BLOB_CACHE:
+                    m_blobCacheSize = std::stoull(arg) * MEGABYTE;
+                    break;
+                case OptState::RECORD_FILE:
+                    m_recordFile.assign(arg);
+                    break;
+                case OptState::REPLAY_FILE:
+                    m_replayFile.assign(arg);
+                    break;
+                case OptState::ITERATIONS:
+                    m_iterations = static_cast<unsigned>(std::stoul(arg));
+                    break;
+                case OptState::RESULTS_FILE:
+                    m_resultsFile.assign(arg);
+                    break;
+                case OptState::BASELINE_FILE:
+                    m_baselineFile.assign(arg);
+                    break;
+                case OptState::THRESHOLD:
+                    m_threshold = std::stod(arg);
+                    break;
+                case OptState::LOAD_RATE:
+                    m_loadRate = std::stod(arg);
+                    break;
+                case OptState::LOAD_DURATION:
+                    m_loadDuration = static_cast<unsigned>(std::stoul(arg));
+                    break;
+                case OptState::LOAD_CONNECTIONS:
+                    m_loadConnections = static_cast<unsigned>(std::stoul(arg));
+                    break;
+                case OptState::WORKLOAD_READERS:
+                    m_workloadReaders = static_cast<unsigned>(std::stoul(arg));
+                    break;
+                case OptState::WORKLOAD_WRITERS:
+                    m_workloadWriters = static_cast<unsigned>(std::stoul(arg));
+                    break;
+                case OptState::WORKLOAD_SCENARIO:
+                    setWorkloadScenario(arg);
+                    break;
                 default:
                     continue;
                 }
             }
         }
-        if (m_database.empty()) {
+        if (m_database.empty() && m_replayFile.empty()) {
             std::cerr << "Error: the option '--database' is required but missing" << std::endl;
             exit(-1);
         }
+        if (m_iterations == 0) {
+            std::cerr << "Error: the number of iterations must be positive" << std::endl;
+            exit(-1);
+        }
+        if (m_spanSample.has_value() && m_spanSample.value() == 0) {
+            std::cerr << "Error: the span sampling interval must be positive" << std::endl;
+            exit(-1);
+        }
+        if (m_reuseCalls.has_value() && m_reuseCalls.value() <= 0) {
+            std::cerr << "Error: the number of reuse calls must be positive" << std::endl;
+            exit(-1);
+        }
+        if (m_lookups.has_value() && m_lookups.value() <= 0) {
+            std::cerr << "Error: the number of lookups must be positive" << std::endl;
+            exit(-1);
+        }
+        if (m_blobCacheSize.has_value() && (m_blobCacheSize.value() == 0 || !m_lookups.has_value())) {
+            std::cerr << "Error: the BLOB cache size must be positive and requires --lookups" << std::endl;
+            exit(-1);
+        }
+        if (m_loadRate.has_value() && (m_loadRate.value() <= 0 || m_loadDuration == 0 || m_loadConnections == 0)) {
+            std::cerr << "Error: the load rate, duration and connections must be positive" << std::endl;
+            exit(-1);
+        }
+        if (m_workloadReaders.has_value() && (m_workloadReaders.value() == 0 || m_loadDuration == 0)) {
+            std::cerr << "Error: the number of workload readers and the load duration must be positive" << std::endl;
+            exit(-1);
+        }
+    }
+
+    /// <summary>
+    /// Extracts the database path or alias from a connection string:
+    /// inet://host:port/path, xnet://path, host:path or a plain path.
+    /// </summary>
+    std::string databasePath(const std::string& connectionString)
+    {
+        if (const auto pos = connectionString.find("://"); pos != std::string::npos) {
+            const std::string protocol = connectionString.substr(0, pos);
+            const std::string rest = connectionString.substr(pos + 3);
+            if (protocol == "xnet") {
+                return rest;
+            }
+            const auto slash = rest.find('/');
+            return slash == std::string::npos ? rest : rest.substr(slash + 1);
+        }
+        // a colon at position 1 is a Windows drive letter, not a host name
+        if (const auto pos = connectionString.find(':'); pos != std::string::npos && pos > 1) {
+            return connectionString.substr(pos + 1);
+        }
+        return connectionString;
+    }
+
+    void TestApp::compareProviders(Firebird::ThrowStatusWrapper* status, Firebird::IProvider* provider)
+    {
+        struct ProviderRun {
+            const char* label;
+            std::string database;
+            std::string providers;
+        };
+
+        const std::string path = databasePath(m_database);
+        const ProviderRun runs[] = {
+            { "embedded", path, "Providers=" + m_engineProvider },
+            { "loopback", "inet://localhost/" + path, "Providers=Remote" }
+        };
+
+        // the monitoring attachment watches the main attachment only
+        MonStatSource* monSource = monStatSource;
+        monStatSource = nullptr;
+
+        // the runs are kept out of m_results, so they are neither saved with --results nor compared with a baseline
+        ResultLog runResults[std::size(runs)];
+        Firebird::IUtil* util = master->getUtilInterface();
+        for (size_t i = 0; i < std::size(runs); i++) {
+            const auto& run = runs[i];
+            std::string config = run.providers;
+            if (m_wireCompression) {
+                config += "\nWireCompression=True";
+            }
+            Firebird::AutoDispose<Firebird::IXpbBuilder> dpbBuilder = util->getXpbBuilder(status, Firebird::IXpbBuilder::DPB, nullptr, 0);
+            dpbBuilder->insertString(status, isc_dpb_user_name, m_username.c_str());
+            dpbBuilder->insertString(status, isc_dpb_password, m_password.c_str());
+            dpbBuilder->insertString(status, isc_dpb_lc_ctype, m_charset.c_str());
+            dpbBuilder->insertString(status, isc_dpb_config, config.c_str());
+
+            std::cout << std::endl << std::format("===== Provider: {}, database: {} =====", run.label, run.database) << std::endl;
+
+            Firebird::AutoRelease<Firebird::IAttachment> att;
+            try {
+                att = provider->attachDatabase(status, run.database.c_str(),
+                    dpbBuilder->getBufferLength(status), dpbBuilder->getBuffer(status));
+            }
+            catch (const Firebird::FbException& e) {
+                // e.g. an engine plugin with another name, see --engine
+                char message_buffer[2048];
+                util->formatStatus(message_buffer, static_cast<unsigned int>(std::size(message_buffer)), e.getStatus());
+                std::cout << std::format("Cannot attach with {}: {}", run.providers, message_buffer) << std::endl;
+                std::cout << "The comparison of providers is skipped" << std::endl;
+                monStatSource = monSource;
+                return;
+            }
+
+            m_titlePrefix = std::format("[{}] ", run.label);
+            printTestHeader(m_titlePrefix + "Warming up the cache");
+            cacheWarmingUp(status, att);
+            runScanTests(status, att, runResults[i]);
+            m_titlePrefix.clear();
+
+            att->detach(status);
+            att.release();
+        }
+
+        monStatSource = monSource;
+
+        // the difference is the cost of the remote protocol and the network stack
+        printTestHeader("Comparison of embedded and loopback providers");
+        std::cout << "CPU is the time of this process: the embedded run includes the engine, the loopback run only the client." << std::endl;
+        std::cout << "The CPU delta is therefore not the client cost of the remote protocol; the server CPU is not measured." << std::endl;
+        std::cout << std::format("  {:<52} {:>9} {:>9} {:>9} {:>9} {:>10} {:>11} {:>12}",
+            "test", "emb, ms", "tcp, ms", "emb cpu", "tcp cpu", "cpu delta", "us per row", "us per BLOB") << std::endl;
+        for (const auto& scenario : runResults[0].scenarios()) {
+            const auto* loopback = runResults[1].find(scenario.name);
+            if (!loopback || scenario.samples.empty() || loopback->samples.empty()) {
+                continue;
+            }
+            const auto& emb = scenario.samples.back();
+            const auto& tcp = loopback->samples.back();
+            const auto overhead = static_cast<double>((tcp.elapsed - emb.elapsed).count());
+            const std::string perBlob = tcp.blob_count > 0 ? std::format("{:.2f}", overhead / static_cast<double>(tcp.blob_count)) : "-";
+            std::cout << std::format("  {:<52} {:>9} {:>9} {:>9} {:>9} {:>10} {:>11.2f} {:>12}", scenario.name,
+                emb.elapsed.count() / 1000, tcp.elapsed.count() / 1000, emb.cpu.count() / 1000, tcp.cpu.count() / 1000,
+                (tcp.cpu - emb.cpu).count() / 1000,
+                overhead / static_cast<double>(std::max<int64_t>(tcp.record_count, 1)), perBlob) << std::endl;
+        }
+    }
+
+    int TestApp::runReplay()
+    {
+        std::cout << "===== Replay of fetched data without the server =====" << std::endl << std::endl;
+        try {
+            replayRecording(m_replayFile);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    void TestApp::setKeyDistribution(const std::string& name)
+    {
+        for (auto distribution : { Key_Distribution::UNIFORM, Key_Distribution::ZIPFIAN, Key_Distribution::HOTSET }) {
+            if (name == key_distribution_name(distribution)) {
+                m_keyDistributions = { distribution };
+                return;
+            }
+        }
+        std::cerr << "Error: unknown key distribution '" << name << "'. See: --help" << std::endl;
+        exit(-1);
+    }
+
+    void TestApp::setWorkloadScenario(const std::string& name)
+    {
+        for (auto scenario : { Reader_Scenario::LOOKUP, Reader_Scenario::SCAN }) {
+            if (name == reader_scenario_name(scenario)) {
+                m_workloadScenario = scenario;
+                return;
+            }
+        }
+        std::cerr << "Error: unknown workload scenario '" << name << "'. See: --help" << std::endl;
+        exit(-1);
     }
 
     int TestApp::run() 
@@ -891,6 +5182,16 @@ Database options:
         Firebird::AutoDispose<Firebird::IStatus> st = master->getStatus();
         Firebird::ThrowStatusWrapper status(st);
         Firebird::IUtil* util = master->getUtilInterface();
+        int exitCode = 0;
+        AllocTracker::enable(m_allocStat);
+        sizeBucketStat = m_sizeBuckets;
+        WireSpans::setSampleEvery(m_spanSample.value_or(0));
+        if (m_perfStat) {
+            std::string perfError;
+            if (!PerfCounters::open(perfError)) {
+                std::cout << "CPU counters are not available: " << perfError << std::endl << std::endl;
+            }
+        }
         try {
             Firebird::AutoRelease<Firebird::IProvider> provider = master->getDispatcher();
             Firebird::AutoDispose<Firebird::IXpbBuilder> dpbBuilder = util->getXpbBuilder(&status, Firebird::IXpbBuilder::DPB, nullptr, 0);
@@ -906,52 +5207,284 @@ Database options:
             Firebird::AutoRelease<Firebird::IAttachment> att = provider->attachDatabase(&status, m_database.c_str(),
                 dpbBuilder->getBufferLength(&status), dpbBuilder->getBuffer(&status));
 
+            // additional attachments with the same parameters, may be called from worker threads
+            const std::vector<unsigned char> dpb(dpbBuilder->getBuffer(&status), dpbBuilder->getBuffer(&status) + dpbBuilder->getBufferLength(&status));
+            const AttachFactory connect = [this, &provider, &dpb](Firebird::ThrowStatusWrapper* status) {
+                return provider->attachDatabase(status, m_database.c_str(), static_cast<unsigned>(dpb.size()), dpb.data());
+            };
+
             std::cout << "Firebird server version" << std::endl;
             VCallback vCallback;
             util->getFbVersion(&status, att, &vCallback);
 
-            std::cout << std::endl << "** Warming up the cache **" << std::endl;
-            std::cout << "------------------------------------------------------------------------------------" << std::endl;
+            Firebird::AutoDelete<MonStatSource> monSource;
+            if (m_monStat) {
+                // a separate attachment, so monitoring queries are not counted in the tested wire statistics
+                monSource = new MonStatSource(&status, connect(&status), getAttachmentId(&status, att));
+                monStatSource = monSource;
+            }
+
+            Firebird::AutoDelete<WireTracer> tracer;
+            if (!m_traceFile.empty()) {
+                tracer = new WireTracer(m_traceFile);
+                wireTracer = tracer;
+            }
+
+            std::optional<ResultLog> baseline;
+            if (!m_baselineFile.empty()) {
+                baseline = ResultLog::load(m_baselineFile);
+            }
+
+            printTestHeader("Warming up the cache");
             cacheWarmingUp(&status, att);
 
-            std::cout << std::endl << "** Test read short BLOBs **" << std::endl;
-            std::cout << "------------------------------------------------------------------------------------" << std::endl;
-            testWithReadBlob(&status, att, Read_Blob_Kind::SHORT_BLOB, m_max_inline_blob_size, m_limit_rows);
+            if (m_packed) {
+                printTestHeader("Preparing LZ4 packed BLOBs");
+                preparePackedTable(&status, att);
+            }
+
+            for (unsigned i = 1; i <= m_iterations; i++) {
+                if (m_iterations > 1) {
+                    std::cout << std::endl << std::format("===== Iteration {} of {} =====", i, m_iterations) << std::endl;
+                }
+                runScanTests(&status, att, m_results);
+            }
+
+            if (m_compareProviders) {
+                compareProviders(&status, provider);
+            }
+
+            if (!m_recordFile.empty()) {
+                printTestHeader("Record mixed BLOBs and VARCHARs with optimize");
+                recordMixedRead(&status, att, m_recordFile, m_max_inline_blob_size, m_limit_rows);
+            }
+
+            if (m_isolationMatrix) {
+                testIsolationMatrix(&status, att, connect, m_matrixWriter, m_max_inline_blob_size, m_limit_rows);
+            }
+
+            if (m_reuseCalls.has_value()) {
+                const std::pair<Statement_Reuse_Kind, const char*> reuseKinds[] = {
+                    { Statement_Reuse_Kind::PREPARE_PER_CALL, "prepare and start transaction per call" },
+                    { Statement_Reuse_Kind::STATEMENT_CACHE, "client-side statement cache, transaction per call" },
+                    { Statement_Reuse_Kind::REUSE_STATEMENT, "prepared once, transaction per call" },
+                    { Statement_Reuse_Kind::REUSE_STATEMENT_AND_TRANSACTION, "prepared once, single transaction" }
+                };
+                for (const auto& [reuseKind, name] : reuseKinds) {
+                    const std::string title = std::format("Test statement reuse: {}", name);
+                    printTestHeader(title);
+                    m_results.add(title, testStatementReuse(&status, att, reuseKind, m_reuseCalls.value(), m_max_inline_blob_size, m_limit_rows));
+                }
+            }
+
+            if (m_lookups.has_value()) {
+                std::vector<std::optional<unsigned short>> inlineSizes{ 0 };
+                if (m_max_inline_blob_size != std::optional<unsigned short>(0)) {
+                    inlineSizes.push_back(m_max_inline_blob_size);
+                }
+                std::vector<std::optional<size_t>> cacheSizes{ std::nullopt };
+                if (m_blobCacheSize.has_value()) {
+                    cacheSizes.push_back(m_blobCacheSize);
+                }
+                for (auto distribution : m_keyDistributions) {
+                    for (const auto& inlineSize : inlineSizes) {
+                        for (const auto& cacheSize : cacheSizes) {
+                            const std::string title = std::format("Test point lookups, {} keys, {}{}", key_distribution_name(distribution),
+                                inlineSize == std::optional<unsigned short>(0) ? "without inline BLOBs" : "with inline BLOBs",
+                                cacheSize.has_value() ? ", client cache" : "");
+                            printTestHeader(title);
+                            m_results.add(title, testPointLookup(&status, att, distribution, m_lookups.value(), inlineSize, m_limit_rows, cacheSize));
+                        }
+                    }
+                }
+            }
+
+            if (m_loadRate.has_value()) {
+                printTestHeader("Test open-loop load of BLOB lookups");
+                testOpenLoopLoad(&status, att, connect, m_loadRate.value(), std::chrono::seconds(m_loadDuration),
+                    m_loadConnections, m_max_inline_blob_size, m_limit_rows);
+            }
 
-            std::cout << std::endl << "** Test read VARCHAR(8191) **" << std::endl;
-            std::cout << "------------------------------------------------------------------------------------" << std::endl;
-            testReadVarchar(&status, att, m_limit_rows);
+            if (m_workloadReaders.has_value()) {
+                printTestHeader("Test concurrent readers and writers");
+                testConcurrentWorkload(&status, att, connect, m_workloadScenario, m_workloadReaders.value(), m_workloadWriters,
+                    std::chrono::seconds(m_loadDuration), m_max_inline_blob_size, m_limit_rows);
+            }
 
-            std::cout << std::endl << "** Test read all BLOBs **" << std::endl;
-            std::cout << "------------------------------------------------------------------------------------" << std::endl;
-            testWithReadBlob(&status, att, Read_Blob_Kind::ALL_BLOB, m_max_inline_blob_size, m_limit_rows);
+            wireTracer = nullptr;
 
-            std::cout << std::endl << "** Test read mixed BLOBs and VARCHARs **" << std::endl;
-            std::cout << "------------------------------------------------------------------------------------" << std::endl;
-            testMixedRead(&status, att, false, m_max_inline_blob_size, m_limit_rows);
+            if (m_spanSample.has_value()) {
+                printTestHeader("Span statistics");
+                WireSpans::report(std::cout);
+            }
 
-            std::cout << std::endl << "** Test read mixed BLOBs and VARCHARs with optimize **" << std::endl;
-            std::cout << "------------------------------------------------------------------------------------" << std::endl;
-            testMixedRead(&status, att, true, m_max_inline_blob_size, m_limit_rows);
+            if (!m_resultsFile.empty()) {
+                m_results.save(m_resultsFile);
+                std::cout << std::endl << "Results saved to " << m_resultsFile << std::endl;
+            }
 
+            if (baseline) {
+                printTestHeader("Comparison with baseline " + m_baselineFile);
+                if (const int regressions = compareWithBaseline(baseline.value(), m_results, m_threshold); regressions > 0) {
+                    std::cout << "Regressions: " << regressions << std::endl;
+                    exitCode = 2;
+                }
+            }
 
-            std::cout << std::endl << "** Test read only BLOB IDs **" << std::endl;
-            std::cout << "------------------------------------------------------------------------------------" << std::endl;
-            if (m_autoBlobInline) {
-                m_max_inline_blob_size = 0;
+            if (monSource) {
+                monStatSource = nullptr;
+                monSource->detach(&status);
             }
-            testReadBlobId(&status, att, Read_Blob_Kind::ALL_BLOB, m_max_inline_blob_size, m_limit_rows);
 
             att->detach(&status);
             att.release();
         }
         catch (const Firebird::FbException& e) {
+            monStatSource = nullptr;
+            wireTracer = nullptr;
             char message_buffer[2048];
             master->getUtilInterface()->formatStatus(message_buffer, static_cast<unsigned int>(std::size(message_buffer)), e.getStatus());
             std::cerr << "Error: " << message_buffer << std::endl;
             return 1;
         }
-        return 0;
+        catch (const std::exception& e) {
+            monStatSource = nullptr;
+            wireTracer = nullptr;
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return exitCode;
+    }
+
+    void TestApp::runScanTests(Firebird::ThrowStatusWrapper* status, Firebird::IAttachment* att, ResultLog& results)
+    {
+        auto runTest = [this, &results](const std::string& title, auto&& test) {
+            printTestHeader(m_titlePrefix + title);
+            const auto cpu0 = PerfCounters::processCpuTime();
+            auto result = test();
+            result.cpu = PerfCounters::processCpuTime() - cpu0;
+            results.add(title, result);
+            return result;
+        };
+
+        runTest("Test read short BLOBs", [&] {
+            return testWithReadBlob(status, att, Read_Blob_Kind::SHORT_BLOB, m_max_inline_blob_size, m_limit_rows);
+        });
+
+        runTest("Test read VARCHAR(8191)", [&] {
+            return testReadVarchar(status, att, m_limit_rows);
+        });
+
+        const auto allBlobs = runTest("Test read all BLOBs", [&] {
+            return testWithReadBlob(status, att, Read_Blob_Kind::ALL_BLOB, m_max_inline_blob_size, m_limit_rows);
+        });
+
+        runTest("Test read mixed BLOBs and VARCHARs", [&] {
+            return testMixedRead(status, att, false, m_max_inline_blob_size, m_limit_rows);
+        });
+
+        runTest("Test read mixed BLOBs and VARCHARs with optimize", [&] {
+            return testMixedRead(status, att, true, m_max_inline_blob_size, m_limit_rows);
+        });
+
+        if (m_twoPhase) {
+            runTest("Test read two-phase: lengths, VARCHAR batches, BLOBs", [&] {
+                return testTwoPhaseRead(status, att, m_max_inline_blob_size, m_limit_rows);
+            });
+        }
+
+        if (m_chunkedRead) {
+            runTest("Test read chunked VARCHAR rows", [&] {
+                return testReadChunked(status, att, m_limit_rows);
+            });
+        }
+
+        if (m_packed) {
+            const auto packed = runTest("Test read LZ4 packed BLOBs", [&] {
+                return testReadPacked(status, att, m_max_inline_blob_size, m_limit_rows);
+            });
+            std::cout << std::endl << std::format("Plain and packed BLOBs, wire compression {}:", m_wireCompression ? "on" : "off") << std::endl;
+            std::cout << std::format("  {:<12} {:>12} {:>10} {:>11} {:>14} {:>14}",
+                "storage", "time, ms", "cpu, ms", "roundtrips", "recv bytes", "wire bytes") << std::endl;
+            for (const auto& [name, result] : { std::pair{ "plain", allBlobs }, std::pair{ "LZ4 packed", packed } }) {
+                std::cout << std::format("  {:<12} {:>12.1f} {:>10.1f} {:>11} {:>14} {:>14}", name,
+                    result.elapsed.count() / 1000.0, result.cpu.count() / 1000.0, result.wire.wire_roundtrips,
+                    result.wire.wire_in_bytes, result.wire.wire_rcv_bytes) << std::endl;
+            }
+        }
+
+        if (m_columnar) {
+            runTest("Test fill result with per-row strings", [&] {
+                return testResultLayout(status, att, Result_Layout::ROW_STRINGS, m_max_inline_blob_size, m_limit_rows);
+            });
+
+            runTest("Test fill columnar result", [&] {
+                return testResultLayout(status, att, Result_Layout::COLUMNAR, m_max_inline_blob_size, m_limit_rows);
+            });
+        }
+
+        if (m_deferredBlobs) {
+            // batch size 1 is the per-row open/read/close pattern
+            std::vector<std::pair<size_t, TestResult>> batches;
+            for (const size_t batchSize : { 1, 4, 16, 64, 256 }) {
+                const std::string title = std::format("Test read all BLOBs in batches of {} rows", batchSize);
+                batches.emplace_back(batchSize, runTest(title, [&] {
+                    return testDeferredBlobRead(status, att, batchSize, m_max_inline_blob_size, m_limit_rows);
+                }));
+            }
+            std::cout << std::endl << "Deferred BLOB batches:" << std::endl;
+            std::cout << std::format("  {:>6} {:>12} {:>12} {:>10} {:>12}", "batch", "time, ms", "roundtrips", "time, %", "roundtrips, %") << std::endl;
+            const auto& perRow = batches.front().second;
+            for (const auto& [batchSize, result] : batches) {
+                std::cout << std::format("  {:>6} {:>12} {:>12} {:>10.1f} {:>12.1f}", batchSize,
+                    result.elapsed.count() / 1000, result.wire.wire_roundtrips,
+                    result.elapsed.count() * 100.0 / std::max<int64_t>(perRow.elapsed.count(), 1),
+                    result.wire.wire_roundtrips * 100.0 / std::max<int64_t>(perRow.wire.wire_roundtrips, 1)) << std::endl;
+            }
+        }
+
+        if (m_serverBlobs) {
+            struct ServerBlobRow {
+                const char* name;
+                ServerBlobStat blobStat;
+                TestResult result;
+            };
+            std::vector<ServerBlobRow> rows;
+            for (const auto& query : serverBlobQueries()) {
+                ServerBlobStat blobStat;
+                try {
+                    const auto result = runTest(std::format("Test read server BLOBs: {}", query.name), [&] {
+                        return testServerBlobRead(status, att, query, blobStat, m_max_inline_blob_size, m_limit_rows);
+                    });
+                    rows.push_back({ query.name, blobStat, result });
+                }
+                catch (const Firebird::FbException& e) {
+                    // e.g. BLOB_APPEND before Firebird 5
+                    char message_buffer[2048];
+                    master->getUtilInterface()->formatStatus(message_buffer, static_cast<unsigned int>(std::size(message_buffer)), e.getStatus());
+                    std::cout << "Not supported: " << message_buffer << std::endl;
+                }
+            }
+            if (!rows.empty()) {
+                std::cout << std::endl << "Server-generated BLOBs:" << std::endl;
+                std::cout << std::format("  {:<36} {:>8} {:>8} {:>10} {:>12} {:>8} {:>11} {:>14}",
+                    "query", "records", "inline", "blob rt", "time, ms", "time, %", "roundtrips", "recv bytes") << std::endl;
+                const auto& stored = rows.front().result;
+                for (const auto& row : rows) {
+                    std::cout << std::format("  {:<36} {:>8} {:>8} {:>10} {:>12.1f} {:>8.1f} {:>11} {:>14}",
+                        row.name, row.result.record_count, row.blobStat.inline_count, row.blobStat.blob_roundtrips,
+                        row.result.elapsed.count() / 1000.0,
+                        row.result.elapsed.count() * 100.0 / std::max<int64_t>(stored.elapsed.count(), 1),
+                        row.result.wire.wire_roundtrips, row.result.wire.wire_in_bytes) << std::endl;
+                }
+            }
+        }
+
+        // BLOB contents are not read, so nothing has to be sent inline
+        const auto blobIdInlineSize = m_autoBlobInline ? std::optional<unsigned short>(0) : m_max_inline_blob_size;
+        runTest("Test read only BLOB IDs", [&] {
+            return testReadBlobId(status, att, Read_Blob_Kind::ALL_BLOB, blobIdInlineSize, m_limit_rows);
+        });
     }
 
 }